@@ -0,0 +1,91 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Arduino core stand-in for the native simulator build
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/delay.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+typedef uint8_t byte;
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define SDA 18
+#define SCL 19
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define MSBFIRST 1
+
+#define F(string_literal) (string_literal)
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+#define digitalPinToPCICR(p) (((p) >= 0 && (p) <= 21) ? (&PCICR) : ((uint8_t *)0))
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : (((p) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(p) (((p) <= 7) ? (&PCMSK2) : (((p) <= 13) ? (&PCMSK0) : (((p) <= 21) ? (&PCMSK1) : ((uint8_t *)0))))
+#define digitalPinToPCMSKbit(p) (((p) <= 7) ? (p) : (((p) <= 13) ? ((p) - 8) : ((p) - 14)))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+
+char *ultoa(unsigned long value, char *text, int base);
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual int availableForWrite() { return 0; }
+
+  size_t write(const char *str);
+  size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *str);
+  size_t print(char c);
+  size_t print(unsigned long value, int base = 10);
+  size_t print(long value, int base = 10);
+  size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = 10) { return print((long)value, base); }
+  size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+
+  size_t println();
+  size_t println(const char *str);
+  size_t println(unsigned long value, int base = 10);
+  size_t println(long value, int base = 10);
+  size_t println(unsigned int value, int base = 10) { return println((unsigned long)value, base); }
+  size_t println(int value, int base = 10) { return println((long)value, base); }
+};
+
+#include "HardwareSerial.h"
+
+void setup();
+void loop();
+
+#endif
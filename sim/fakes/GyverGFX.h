@@ -0,0 +1,91 @@
+#ifndef SIM_GYVERGFX_H
+#define SIM_GYVERGFX_H
+
+#include "Arduino.h"
+
+#define GFX_CLEAR 0
+#define GFX_FILL 1
+#define GFX_STROKE 2
+
+// 5x7 font columns for ' '..'Z', bit 0 is the top row, lower case is drawn upper case
+extern const uint8_t SIM_FONT[][5];
+
+// drawing primitives of GyverGFX 1.7 the firmware uses
+class GyverGFX : public Print
+{
+public:
+  GyverGFX(int width, int height) : _width(width), _height(height) {}
+
+  virtual void dot(int x, int y, uint8_t fill = GFX_FILL) = 0;
+
+  void setCursor(int x, int y)
+  {
+    _x = x;
+    _y = y;
+  }
+
+  size_t write(uint8_t c) override
+  {
+    if (c >= 'a' && c <= 'z')
+    {
+      c -= 'a' - 'A';
+    }
+    for (uint8_t col = 0; col < 6; col++)
+    {
+      uint8_t bits = (col < 5 && c >= ' ' && c <= 'Z') ? SIM_FONT[c - ' '][col] : 0;
+      for (uint8_t row = 0; row < 8; row++)
+      {
+        dot(_x + col, _y + row, (bits >> row) & 1);
+      }
+    }
+    _x += 6;
+    return 1;
+  }
+  using Print::write;
+
+  void fastLineH(int y, int x0, int x1, uint8_t fill = GFX_FILL)
+  {
+    for (int x = x0; x <= x1; x++)
+    {
+      dot(x, y, fill);
+    }
+  }
+
+  void fastLineV(int x, int y0, int y1, uint8_t fill = GFX_FILL)
+  {
+    for (int y = y0; y <= y1; y++)
+    {
+      dot(x, y, fill);
+    }
+  }
+
+  void lineH(int y, int x0, int x1, uint8_t fill = GFX_FILL) { fastLineH(y, x0, x1, fill); }
+
+  void lineV(int x, int y0, int y1, uint8_t fill = GFX_FILL) { fastLineV(x, y0, y1, fill); }
+
+  void rect(int x0, int y0, int x1, int y1, uint8_t fill = GFX_FILL)
+  {
+    if (fill == GFX_STROKE)
+    {
+      fastLineH(y0, x0, x1);
+      fastLineH(y1, x0, x1);
+      fastLineV(x0, y0, y1);
+      fastLineV(x1, y0, y1);
+      return;
+    }
+    for (int y = y0; y <= y1; y++)
+    {
+      fastLineH(y, x0, x1, fill);
+    }
+  }
+
+  void rectWH(int x, int y, int w, int h, uint8_t fill = GFX_FILL) { rect(x, y, x + w - 1, y + h - 1, fill); }
+
+protected:
+  int _width;
+  int _height;
+  int _x = 0;
+  int _y = 0;
+};
+
+#endif
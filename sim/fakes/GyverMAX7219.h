@@ -0,0 +1,105 @@
+#ifndef SIM_GYVERMAX7219_H
+#define SIM_GYVERMAX7219_H
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "GyverGFX.h"
+
+/**
+ * MAX7219 chain: buffer holds 8 rows of WIDTH * HEIGHT modules,
+ * one byte is a row of a module, bit 7 is the leftmost pixel.
+ */
+template <uint8_t WIDTH, uint8_t HEIGHT, uint8_t CSpin, uint8_t DATpin = 0, uint8_t CLKpin = 0>
+class MAX7219 : public GyverGFX
+{
+public:
+  MAX7219() : GyverGFX(WIDTH * 8, HEIGHT * 8) {}
+
+  void begin()
+  {
+    pinMode(CSpin, OUTPUT);
+    digitalWrite(CSpin, HIGH);
+    sendCMD(0x0F, 0x00);
+    sendCMD(0x0B, 0x07);
+    sendCMD(0x09, 0x00);
+    sendCMD(0x0C, 0x01);
+    clear();
+    update();
+  }
+
+  void setBright(uint8_t value) { sendCMD(0x0A, value); }
+
+  void setPower(bool value) { sendCMD(0x0C, value); }
+
+  void clear() { fill(0); }
+
+  void fill(uint8_t data = 255) { memset(buffer, data, sizeof(buffer)); }
+
+  void dot(int x, int y, uint8_t fill = GFX_FILL) override
+  {
+    if (x < 0 || x >= WIDTH * 8 || y < 0 || y >= HEIGHT * 8)
+    {
+      return;
+    }
+    uint8_t &row = buffer[(y & 7) * _amount + (y >> 3) * WIDTH + (x >> 3)];
+    uint8_t mask = 0x80 >> (x & 7);
+    if (fill)
+    {
+      row |= mask;
+    }
+    else
+    {
+      row &= ~mask;
+    }
+  }
+
+  bool get(int x, int y)
+  {
+    if (x < 0 || x >= WIDTH * 8 || y < 0 || y >= HEIGHT * 8)
+    {
+      return false;
+    }
+    return buffer[(y & 7) * _amount + (y >> 3) * WIDTH + (x >> 3)] & (0x80 >> (x & 7));
+  }
+
+  void update()
+  {
+    int count = 0;
+    for (int k = 0; k < 8; k++)
+    {
+      beginData();
+      for (int i = 0; i < _amount; i++)
+      {
+        sendData(8 - k, buffer[count++]);
+      }
+      endData();
+    }
+  }
+
+  void sendCMD(uint8_t address, uint8_t value)
+  {
+    beginData();
+    for (int i = 0; i < _amount; i++)
+    {
+      sendData(address, value);
+    }
+    endData();
+  }
+
+  uint8_t buffer[WIDTH * HEIGHT * 8];
+
+private:
+  void beginData() { digitalWrite(CSpin, LOW); }
+
+  void endData() { digitalWrite(CSpin, HIGH); }
+
+  void sendData(uint8_t address, uint8_t value)
+  {
+    SPI.transfer(address);
+    SPI.transfer(value);
+  }
+
+  static const int _amount = WIDTH * HEIGHT;
+};
+
+#endif
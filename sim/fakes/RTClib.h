@@ -0,0 +1,33 @@
+#ifndef SIM_RTCLIB_H
+#define SIM_RTCLIB_H
+
+#include "Arduino.h"
+
+#define SECONDS_FROM_1970_TO_2000 946684800
+
+class DateTime
+{
+public:
+  DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+  // __DATE__ and __TIME__
+  DateTime(const char *date, const char *time);
+
+  uint16_t year() const;
+  uint8_t month() const;
+  uint8_t day() const;
+  uint8_t hour() const;
+  uint8_t minute() const;
+  uint8_t second() const;
+
+  uint32_t unixtime() const { return _unixtime; }
+  uint32_t secondstime() const { return _unixtime - SECONDS_FROM_1970_TO_2000; }
+
+  // replaces YYYY, YY, MM, DD, hh, mm, ss in the buffer
+  char *toString(char *buffer) const;
+
+private:
+  uint32_t _unixtime;
+};
+
+#endif
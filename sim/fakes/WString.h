@@ -0,0 +1,8 @@
+#ifndef SIM_WSTRING_H
+#define SIM_WSTRING_H
+
+class String
+{
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define E2END 0x3FF
+
+// finishes the write in progress, the firmware spins on EEPE instead
+void sim_eeprom_busy_wait();
+#define eeprom_busy_wait() sim_eeprom_busy_wait()
+
+uint8_t eeprom_read_byte(const uint8_t *address);
+uint16_t eeprom_read_word(const uint16_t *address);
+uint32_t eeprom_read_dword(const uint32_t *address);
+void eeprom_read_block(void *destination, const void *source, size_t size);
+void eeprom_update_byte(uint8_t *address, uint8_t value);
+void eeprom_update_word(uint16_t *address, uint16_t value);
+void eeprom_update_dword(uint32_t *address, uint32_t value);
+void eeprom_update_block(const void *source, void *destination, size_t size);
+
+#endif
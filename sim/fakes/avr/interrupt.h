@@ -0,0 +1,11 @@
+#ifndef SIM_INTERRUPT_H
+#define SIM_INTERRUPT_H
+
+#include <avr/io.h>
+
+// the simulator calls handlers between loop() passes, nothing to mask
+#define ISR(vector) extern "C" void vector(void)
+#define cli()
+#define sei()
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SIM_IO_H
+#define SIM_IO_H
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+// registers the firmware touches, the simulator reads them back
+extern volatile uint8_t TIMSK0;
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+// setting EERIE fires EE_READY at once while the EEPROM is idle
+class sim_eecr_register
+{
+public:
+  sim_eecr_register &operator=(uint8_t value);
+  sim_eecr_register &operator|=(uint8_t value) { return *this = bits | value; }
+  sim_eecr_register &operator&=(uint8_t value) { return *this = bits & value; }
+  operator uint8_t() const { return bits; }
+
+  uint8_t bits;
+};
+
+extern sim_eecr_register EECR;
+extern volatile uint8_t EEDR;
+extern volatile uint16_t EEAR;
+extern volatile uint8_t TWBR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWDR;
+
+// writing TWCR starts the next bus action, so it is not a plain byte
+class sim_twcr_register
+{
+public:
+  sim_twcr_register &operator=(uint8_t value);
+  sim_twcr_register &operator|=(uint8_t value) { return *this = bits | value; }
+  sim_twcr_register &operator&=(uint8_t value) { return *this = bits & value; }
+  operator uint8_t() const { return bits; }
+
+  uint8_t bits;
+};
+
+extern sim_twcr_register TWCR;
+
+extern volatile uint8_t SPCR;
+extern volatile uint8_t SPSR;
+
+// writing SPDR shifts a byte out to the display chain
+class sim_spdr_register
+{
+public:
+  sim_spdr_register &operator=(uint8_t value);
+  operator uint8_t() const { return 0; }
+};
+
+extern sim_spdr_register SPDR;
+
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TIMSK1;
+
+// Timer1 counts the DS3231 32K output, reading it samples the virtual clock
+class sim_tcnt1_register
+{
+public:
+  operator uint16_t() const;
+};
+
+extern sim_tcnt1_register TCNT1;
+
+extern volatile uint8_t TCCR2A;
+extern volatile uint8_t TCCR2B;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2A;
+extern volatile uint8_t TIMSK2;
+extern volatile uint8_t TIFR2;
+
+#define TOIE0 0
+
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+#define SPR0 0
+#define SPR1 1
+#define MSTR 4
+#define SPE 6
+#define SPIE 7
+#define SPI2X 0
+#define SPIF 7
+
+#define CS10 0
+#define CS11 1
+#define CS12 2
+
+#define WGM21 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define OCIE2A 1
+#define OCF2A 1
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SIM_SLEEP_H
+#define SIM_SLEEP_H
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 2
+
+void set_sleep_mode(uint8_t mode);
+void sleep_enable();
+void sleep_disable();
+// jumps the virtual clock to the next interruption
+void sleep_cpu();
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef SIM_CRC16_H
+#define SIM_CRC16_H
+
+#include <stdint.h>
+
+// C version from the avr-libc documentation
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+#endif
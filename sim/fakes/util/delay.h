@@ -0,0 +1,7 @@
+#ifndef SIM_DELAY_H
+#define SIM_DELAY_H
+
+void _delay_ms(double ms);
+void _delay_us(double us);
+
+#endif
@@ -0,0 +1,1192 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <RTClib.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include <util/twi.h>
+#include <poll.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <deque>
+#include "hardware.h"
+
+#define SIM_PINS 22
+#define SIM_DISPLAY_CS_PIN 10
+#define SIM_EEPROM_SIZE (E2END + 1)
+#define SIM_SERIAL_TX_SIZE 64
+#define SIM_DS3231_ADDRESS 0x68
+#define SIM_DS3231_REGISTERS 0x13
+#define SIM_DS3231_STATUS 0x0F
+#define SIM_DS3231_TEMPERATURE 0x11
+#define SIM_DS3231_EN32KHZ 0x08
+// 9 clocks of a byte and its ACK at 100 kHz
+#define SIM_TWI_BYTE_US 90
+// a byte at 1 MHz
+#define SIM_SPI_BYTE_US 8
+
+extern "C" void PCINT0_vect(void);
+extern "C" void PCINT1_vect(void);
+extern "C" void PCINT2_vect(void);
+extern "C" void EE_READY_vect(void);
+extern "C" void TWI_vect(void);
+extern "C" void SPI_STC_vect(void);
+extern "C" void TIMER2_COMPA_vect(void);
+
+struct pin_event
+{
+  uint8_t pin;
+  bool level;
+};
+
+sim_counters sim_stats;
+
+volatile uint8_t TIMSK0 = _BV(TOIE0);
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCMSK0 = 0;
+volatile uint8_t PCMSK1 = 0;
+volatile uint8_t PCMSK2 = 0;
+sim_eecr_register EECR = {0};
+volatile uint8_t EEDR = 0;
+volatile uint16_t EEAR = 0;
+volatile uint8_t TWBR = 0;
+volatile uint8_t TWSR = 0;
+volatile uint8_t TWDR = 0;
+sim_twcr_register TWCR = {0};
+volatile uint8_t SPCR = 0;
+volatile uint8_t SPSR = 0;
+sim_spdr_register SPDR;
+volatile uint8_t TCCR1A = 0;
+volatile uint8_t TCCR1B = 0;
+volatile uint8_t TIMSK1 = 0;
+sim_tcnt1_register TCNT1;
+volatile uint8_t TCCR2A = 0;
+volatile uint8_t TCCR2B = 0;
+volatile uint8_t TCNT2 = 0;
+volatile uint8_t OCR2A = 0;
+volatile uint8_t TIMSK2 = 0;
+volatile uint8_t TIFR2 = 0;
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+// virtual clock
+uint64_t now_us = 0;
+std::multimap<uint64_t, pin_event> pin_events;
+
+// pins, all pulled up, buttons short them to ground
+bool pin_levels[SIM_PINS];
+void (*int0_handler)(void) = NULL;
+void (*int1_handler)(void) = NULL;
+
+// DS3231: time counts from rtc_base at rtc_base_us, SQW falls on every second
+uint32_t rtc_base = 0;
+uint64_t rtc_base_us = 0;
+uint64_t sqw_delivered_us = 0;
+bool rtc_lost_power = false;
+// off the bus: no ACK, no SQW and no 32K
+bool rtc_present = true;
+uint8_t ds3231[SIM_DS3231_REGISTERS];
+uint8_t ds3231_pointer = 0;
+bool ds3231_time_written = false;
+// the countdown chain restarts on the ACK of the seconds byte
+uint64_t ds3231_seconds_written_us = 0;
+
+// TWI master: a byte on the wire finishes at twi_done_us
+bool twi_busy = false;
+uint64_t twi_done_us = 0;
+bool twi_bus_owned = false;
+bool twi_selected = false;
+bool twi_master_reading = false;
+bool twi_pointer_written = false;
+uint8_t twi_next_status = 0;
+uint8_t twi_next_data = 0;
+
+void twi_command(uint8_t value);
+void twi_complete();
+void spi_complete();
+
+// MAX7219 chain: bytes of the current CS frame and the latched rows
+uint8_t spi_frame[2 * SIM_PANEL_WIDTH];
+size_t spi_frame_size = 0;
+bool spi_selected = false;
+uint8_t panel_rows[8][SIM_PANEL_WIDTH / 8];
+// byte written to SPDR is on the wire until spi_done_us
+bool spi_shifting = false;
+uint64_t spi_done_us = 0;
+
+// Timer2 in CTC mode, only its compare match interruption is modelled
+const uint16_t TIMER2_PRESCALERS[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+bool timer2_armed = false;
+uint64_t timer2_match_us = 0;
+
+uint8_t eeprom[SIM_EEPROM_SIZE];
+// write started by the EEPE bit, it lands after 3.3 ms
+bool eeprom_writing = false;
+// EE_READY runs, its register writes don't fire it again
+bool eeprom_in_handler = false;
+uint64_t eeprom_write_done_us = 0;
+uint16_t eeprom_write_address = 0;
+uint8_t eeprom_write_value = 0;
+
+FILE *serial_sink = NULL;
+unsigned long serial_baud = 9600;
+uint64_t serial_tx_free_at = 0;
+std::deque<uint8_t> serial_rx;
+
+// realtime runs: the virtual clock follows the wall clock, serial bytes
+// cross a file descriptor at UART speed both ways
+int serial_fd = -1;
+std::chrono::steady_clock::time_point realtime_origin;
+// bytes on the RX line, the front one is in by serial_rx_line_us
+std::deque<uint8_t> serial_rx_line;
+uint64_t serial_rx_line_us = 0;
+// bytes on the TX line with the time their stop bit is out
+std::deque<std::pair<uint64_t, uint8_t>> serial_tx_line;
+bool cpu_sleeping = false;
+
+struct hardware_reset
+{
+  hardware_reset()
+  {
+    for (uint8_t i = 0; i < SIM_PINS; i++)
+    {
+      pin_levels[i] = HIGH;
+    }
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    ds3231[SIM_DS3231_TEMPERATURE] = 25;
+    ds3231[SIM_DS3231_STATUS] = SIM_DS3231_EN32KHZ;
+  }
+} hardware_reset_instance;
+
+uint64_t sim_now_us()
+{
+  return now_us;
+}
+
+/**
+ * The next SQW edge, which is the one at now_us when another event of the
+ * same microsecond was delivered before it.
+ */
+uint64_t next_sqw_us()
+{
+  uint64_t edge = rtc_base_us + (now_us - rtc_base_us) / 1000000 * 1000000;
+  if (edge == now_us && edge != rtc_base_us && edge != sqw_delivered_us)
+  {
+    return edge;
+  }
+  return edge + 1000000;
+}
+
+uint64_t timer2_period_us()
+{
+  return (uint64_t)(OCR2A + 1) * TIMER2_PRESCALERS[TCCR2B & 7] / (F_CPU / 1000000);
+}
+
+/**
+ * Follows the firmware starting and stopping Timer2, the first match comes
+ * a period after it is noticed running.
+ */
+bool timer2_running()
+{
+  if (!(TCCR2B & 7) || !(TIMSK2 & _BV(OCIE2A)))
+  {
+    timer2_armed = false;
+    return false;
+  }
+  if (!timer2_armed)
+  {
+    timer2_armed = true;
+    timer2_match_us = now_us + timer2_period_us();
+  }
+  return true;
+}
+
+uint64_t sim_next_event_us()
+{
+  uint64_t next = next_sqw_us();
+  if (!pin_events.empty() && pin_events.begin()->first < next)
+  {
+    next = pin_events.begin()->first;
+  }
+  if (eeprom_writing && eeprom_write_done_us < next)
+  {
+    next = eeprom_write_done_us;
+  }
+  if (twi_busy && twi_done_us < next)
+  {
+    next = twi_done_us;
+  }
+  if (spi_shifting && spi_done_us < next)
+  {
+    next = spi_done_us;
+  }
+  if (timer2_running() && timer2_match_us < next)
+  {
+    next = timer2_match_us;
+  }
+  if (!serial_rx_line.empty() && serial_rx_line_us < next)
+  {
+    next = serial_rx_line_us;
+  }
+  return next;
+}
+
+uint64_t serial_byte_us();
+
+uint64_t realtime_now_us()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - realtime_origin).count();
+}
+
+/**
+ * In realtime runs, waits for the wall clock to reach the virtual time and
+ * sends the TX bytes done by then. Returns true when serial input came in
+ * first, the virtual clock is at its arrival then.
+ */
+bool realtime_wait(uint64_t time_us)
+{
+  if (serial_fd < 0)
+  {
+    return false;
+  }
+  while (true)
+  {
+    uint64_t wall_us = realtime_now_us();
+    while (!serial_tx_line.empty() && serial_tx_line.front().first <= wall_us && serial_tx_line.front().first <= time_us)
+    {
+      if (write(serial_fd, &serial_tx_line.front().second, 1) < 0)
+      {
+        perror("serial");
+      }
+      serial_tx_line.pop_front();
+    }
+    if (wall_us >= time_us)
+    {
+      return false;
+    }
+    uint64_t until_us = time_us;
+    if (!serial_tx_line.empty() && serial_tx_line.front().first < until_us)
+    {
+      until_us = serial_tx_line.front().first;
+    }
+    struct pollfd input = {serial_fd, POLLIN, 0};
+    struct timespec timeout = {(time_t)((until_us - wall_us) / 1000000), (long)((until_us - wall_us) % 1000000 * 1000)};
+    if (ppoll(&input, 1, &timeout, NULL) <= 0 || !(input.revents & POLLIN))
+    {
+      continue;
+    }
+    uint8_t data[64];
+    ssize_t size = read(serial_fd, data, sizeof(data));
+    if (size <= 0)
+    {
+      continue;
+    }
+    uint64_t arrival_us = realtime_now_us();
+    arrival_us = arrival_us < time_us ? arrival_us : time_us;
+    now_us = arrival_us > now_us ? arrival_us : now_us;
+    if (serial_rx_line.empty())
+    {
+      serial_rx_line_us = now_us + serial_byte_us();
+    }
+    serial_rx_line.insert(serial_rx_line.end(), data, data + size);
+    return true;
+  }
+}
+
+/**
+ * Starts the write the firmware armed with EEPE, or fires EE_READY for as
+ * long as it is enabled and the EEPROM is idle.
+ */
+void eeprom_dispatch()
+{
+  if (eeprom_in_handler)
+  {
+    return;
+  }
+  while (!eeprom_writing)
+  {
+    if (EECR & _BV(EEPE))
+    {
+      eeprom_writing = true;
+      eeprom_write_done_us = now_us + 3300;
+      eeprom_write_address = EEAR % SIM_EEPROM_SIZE;
+      eeprom_write_value = EEDR;
+      EECR &= ~_BV(EEMPE);
+      return;
+    }
+    if (!(EECR & _BV(EERIE)))
+    {
+      return;
+    }
+    eeprom_in_handler = true;
+    EE_READY_vect();
+    eeprom_in_handler = false;
+  }
+}
+
+sim_eecr_register &sim_eecr_register::operator=(uint8_t value)
+{
+  bits = value;
+  eeprom_dispatch();
+  return *this;
+}
+
+void eeprom_complete()
+{
+  if (eeprom[eeprom_write_address] != eeprom_write_value)
+  {
+    eeprom[eeprom_write_address] = eeprom_write_value;
+    sim_stats.eeprom_writes++;
+  }
+  eeprom_writing = false;
+  EECR &= ~_BV(EEPE);
+}
+
+void pin_change(uint8_t pin, bool level)
+{
+  if (pin >= SIM_PINS || pin_levels[pin] == level)
+  {
+    return;
+  }
+  pin_levels[pin] = level;
+  sim_stats.pin_changes++;
+
+  uint8_t bit = _BV(digitalPinToPCMSKbit(pin));
+  uint8_t group = digitalPinToPCICRbit(pin);
+  if (!(PCICR & _BV(group)) || !(*digitalPinToPCMSK(pin) & bit))
+  {
+    return;
+  }
+  if (group == 0)
+  {
+    PCINT0_vect();
+  }
+  else if (group == 1)
+  {
+    PCINT1_vect();
+  }
+  else
+  {
+    PCINT2_vect();
+  }
+}
+
+/**
+ * Moves the virtual clock, delivering SQW edges, pin changes, finished
+ * EEPROM writes, TWI and SPI bytes and Timer2 matches on the way.
+ */
+void sim_advance_to(uint64_t time_us)
+{
+  eeprom_dispatch();
+  while (true)
+  {
+    uint64_t next = sim_next_event_us();
+    if (realtime_wait(next < time_us ? next : time_us))
+    {
+      continue;
+    }
+    if (next > time_us)
+    {
+      break;
+    }
+    if (!serial_rx_line.empty() && serial_rx_line_us == next)
+    {
+      // the RX interruption wakes the CPU
+      now_us = serial_rx_line_us;
+      serial_rx.push_back(serial_rx_line.front());
+      serial_rx_line.pop_front();
+      serial_rx_line_us += serial_byte_us();
+      if (cpu_sleeping)
+      {
+        return;
+      }
+      continue;
+    }
+    if (spi_shifting && spi_done_us == sim_next_event_us())
+    {
+      now_us = spi_done_us;
+      spi_complete();
+      continue;
+    }
+    if (timer2_armed && timer2_match_us == sim_next_event_us())
+    {
+      now_us = timer2_match_us;
+      timer2_match_us += timer2_period_us();
+      TIMER2_COMPA_vect();
+      continue;
+    }
+    if (twi_busy && twi_done_us == sim_next_event_us())
+    {
+      now_us = twi_done_us;
+      twi_complete();
+      continue;
+    }
+    if (eeprom_writing && eeprom_write_done_us == sim_next_event_us())
+    {
+      now_us = eeprom_write_done_us;
+      eeprom_complete();
+      eeprom_dispatch();
+      continue;
+    }
+    uint64_t sqw = next_sqw_us();
+    if (!pin_events.empty() && pin_events.begin()->first <= sqw)
+    {
+      now_us = pin_events.begin()->first;
+      pin_event event = pin_events.begin()->second;
+      pin_events.erase(pin_events.begin());
+      pin_change(event.pin, event.level);
+      continue;
+    }
+    now_us = sqw;
+    sqw_delivered_us = sqw;
+    sim_stats.sqw_edges++;
+    if (int0_handler && rtc_present)
+    {
+      int0_handler();
+    }
+  }
+  if (time_us > now_us)
+  {
+    now_us = time_us;
+  }
+}
+
+void sim_drive_pin(uint64_t time_us, uint8_t pin, bool level)
+{
+  pin_events.insert(std::make_pair(time_us, pin_event{pin, level}));
+}
+
+void sim_set_rtc(uint32_t unixtime, bool lost_power)
+{
+  rtc_base = unixtime;
+  rtc_base_us = now_us;
+  rtc_lost_power = lost_power;
+}
+
+void sim_set_rtc_present(bool present)
+{
+  rtc_present = present;
+}
+
+uint32_t sim_rtc_unixtime()
+{
+  return rtc_base + (now_us - rtc_base_us) / 1000000;
+}
+
+bool sim_panel_pixel(uint8_t x, uint8_t y)
+{
+  return panel_rows[y & 7][x >> 3] & (0x80 >> (x & 7));
+}
+
+bool sim_eeprom_load(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (!file)
+  {
+    return false;
+  }
+  size_t size = fread(eeprom, 1, sizeof(eeprom), file);
+  fclose(file);
+  return size == sizeof(eeprom);
+}
+
+bool sim_eeprom_save(const char *path)
+{
+  FILE *file = fopen(path, "wb");
+  if (!file)
+  {
+    return false;
+  }
+  size_t size = fwrite(eeprom, 1, sizeof(eeprom), file);
+  fclose(file);
+  return size == sizeof(eeprom);
+}
+
+void sim_serial_output(FILE *sink)
+{
+  serial_sink = sink;
+}
+
+void sim_serial_input(const uint8_t *data, size_t size)
+{
+  serial_rx.insert(serial_rx.end(), data, data + size);
+}
+
+void sim_serial_realtime(int fd)
+{
+  serial_fd = fd;
+  realtime_origin = std::chrono::steady_clock::now() - std::chrono::microseconds(now_us);
+}
+
+// Arduino core
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+/**
+ * CS of the display latches the collected frame into the modelled chain.
+ */
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin != SIM_DISPLAY_CS_PIN)
+  {
+    return;
+  }
+  if (value == LOW)
+  {
+    spi_selected = true;
+    spi_frame_size = 0;
+    return;
+  }
+  if (!spi_selected)
+  {
+    return;
+  }
+  spi_selected = false;
+  sim_stats.spi_frames++;
+  // the first pair sent travels to the far end, like MAX7219::update() expects
+  for (size_t i = 0; i + 1 < spi_frame_size && i / 2 < SIM_PANEL_WIDTH / 8; i += 2)
+  {
+    uint8_t address = spi_frame[i];
+    if (address >= 1 && address <= 8)
+    {
+      panel_rows[8 - address][i / 2] = spi_frame[i + 1];
+    }
+  }
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < SIM_PINS ? pin_levels[pin] : LOW;
+}
+
+unsigned long millis()
+{
+  return now_us / 1000;
+}
+
+unsigned long micros()
+{
+  return now_us;
+}
+
+void delay(unsigned long ms)
+{
+  sim_advance_to(now_us + ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  sim_advance_to(now_us + us);
+}
+
+void _delay_ms(double ms)
+{
+  sim_advance_to(now_us + (uint64_t)(ms * 1000));
+}
+
+void _delay_us(double us)
+{
+  sim_advance_to(now_us + (uint64_t)us);
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode)
+{
+  if (interrupt == 0)
+  {
+    int0_handler = handler;
+  }
+  else if (interrupt == 1)
+  {
+    int1_handler = handler;
+  }
+}
+
+char *ultoa(unsigned long value, char *text, int base)
+{
+  char digits[33];
+  uint8_t length = 0;
+  do
+  {
+    uint8_t digit = value % base;
+    digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  for (uint8_t i = 0; i < length; i++)
+  {
+    text[i] = digits[length - 1 - i];
+  }
+  text[length] = '\0';
+  return text;
+}
+
+size_t Print::write(const char *str)
+{
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+  {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(const char *str)
+{
+  return write(str);
+}
+
+size_t Print::print(char c)
+{
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  char text[33];
+  char digits[33];
+  uint8_t length = 0;
+  do
+  {
+    uint8_t digit = value % base;
+    digits[length++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  for (uint8_t i = 0; i < length; i++)
+  {
+    text[i] = digits[length - 1 - i];
+  }
+  text[length] = '\0';
+  return write(text);
+}
+
+size_t Print::print(long value, int base)
+{
+  if (value < 0 && base == 10)
+  {
+    return print('-') + print((unsigned long)-value, base);
+  }
+  return print((unsigned long)value, base);
+}
+
+size_t Print::println()
+{
+  return write("\r\n");
+}
+
+size_t Print::println(const char *str)
+{
+  return print(str) + println();
+}
+
+size_t Print::println(unsigned long value, int base)
+{
+  return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base)
+{
+  return print(value, base) + println();
+}
+
+// UART, a byte takes 10 bit times
+
+uint64_t serial_byte_us()
+{
+  return 10000000ULL / serial_baud;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  serial_baud = baud;
+}
+
+void HardwareSerial::flush()
+{
+  if (serial_tx_free_at > now_us)
+  {
+    sim_advance_to(serial_tx_free_at);
+  }
+}
+
+int HardwareSerial::available()
+{
+  return serial_rx.size();
+}
+
+int HardwareSerial::read()
+{
+  if (serial_rx.empty())
+  {
+    return -1;
+  }
+  uint8_t c = serial_rx.front();
+  serial_rx.pop_front();
+  return c;
+}
+
+int HardwareSerial::availableForWrite()
+{
+  if (serial_tx_free_at <= now_us)
+  {
+    return SIM_SERIAL_TX_SIZE;
+  }
+  uint64_t queued = (serial_tx_free_at - now_us + serial_byte_us() - 1) / serial_byte_us();
+  return queued >= SIM_SERIAL_TX_SIZE ? 0 : SIM_SERIAL_TX_SIZE - queued;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  // blocks like the real one when the TX buffer is full
+  while (availableForWrite() == 0)
+  {
+    sim_advance_to(now_us + serial_byte_us());
+  }
+  serial_tx_free_at = (serial_tx_free_at > now_us ? serial_tx_free_at : now_us) + serial_byte_us();
+  sim_stats.serial_bytes++;
+  if (serial_fd >= 0)
+  {
+    serial_tx_line.push_back(std::make_pair(serial_tx_free_at, c));
+  }
+  if (serial_sink)
+  {
+    fputc(c, serial_sink);
+    fflush(serial_sink);
+  }
+  return 1;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  sim_stats.spi_bytes++;
+  if (spi_selected && spi_frame_size < sizeof(spi_frame))
+  {
+    spi_frame[spi_frame_size++] = data;
+  }
+  return 0;
+}
+
+/**
+ * The byte lands in the chain at once, SPIF and the interruption follow a
+ * byte time later.
+ */
+sim_spdr_register &sim_spdr_register::operator=(uint8_t value)
+{
+  SPI.transfer(value);
+  SPSR &= ~_BV(SPIF);
+  spi_shifting = true;
+  spi_done_us = now_us + SIM_SPI_BYTE_US;
+  return *this;
+}
+
+void spi_complete()
+{
+  spi_shifting = false;
+  if ((SPCR & _BV(SPE)) && (SPCR & _BV(SPIE)))
+  {
+    SPI_STC_vect();
+    return;
+  }
+  SPSR |= _BV(SPIF);
+}
+
+// sleep jumps to the next interruption: SQW, a pin change, a peripheral or the Timer0 tick
+
+void set_sleep_mode(uint8_t mode)
+{
+}
+
+void sleep_enable()
+{
+}
+
+void sleep_disable()
+{
+}
+
+void sleep_cpu()
+{
+  sim_stats.sleeps++;
+  uint64_t wake_at = sim_next_event_us();
+  if ((TIMSK0 & _BV(TOIE0)) && now_us + 1024 < wake_at)
+  {
+    wake_at = now_us + 1024;
+  }
+  cpu_sleeping = true;
+  sim_advance_to(wake_at);
+  cpu_sleeping = false;
+}
+
+// EEPROM
+
+void sim_eeprom_busy_wait()
+{
+  eeprom_dispatch();
+  if (eeprom_writing)
+  {
+    sim_advance_to(eeprom_write_done_us);
+  }
+}
+
+uint8_t eeprom_read_byte(const uint8_t *address)
+{
+  sim_stats.eeprom_reads++;
+  return eeprom[(uintptr_t)address % SIM_EEPROM_SIZE];
+}
+
+void eeprom_read_block(void *destination, const void *source, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    ((uint8_t *)destination)[i] = eeprom_read_byte((const uint8_t *)source + i);
+  }
+}
+
+uint16_t eeprom_read_word(const uint16_t *address)
+{
+  uint16_t value;
+  eeprom_read_block(&value, address, sizeof(value));
+  return value;
+}
+
+uint32_t eeprom_read_dword(const uint32_t *address)
+{
+  uint32_t value;
+  eeprom_read_block(&value, address, sizeof(value));
+  return value;
+}
+
+void eeprom_update_byte(uint8_t *address, uint8_t value)
+{
+  uint8_t &cell = eeprom[(uintptr_t)address % SIM_EEPROM_SIZE];
+  if (cell != value)
+  {
+    cell = value;
+    sim_stats.eeprom_writes++;
+    // 3.3 ms per written byte
+    sim_advance_to(now_us + 3300);
+  }
+}
+
+void eeprom_update_block(const void *source, void *destination, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    eeprom_update_byte((uint8_t *)destination + i, ((const uint8_t *)source)[i]);
+  }
+}
+
+void eeprom_update_word(uint16_t *address, uint16_t value)
+{
+  eeprom_update_block(&value, address, sizeof(value));
+}
+
+void eeprom_update_dword(uint32_t *address, uint32_t value)
+{
+  eeprom_update_block(&value, address, sizeof(value));
+}
+
+/**
+ * 32K edges since the SQW phase began while the DS3231 drives them and
+ * Timer1 takes them from T1, so every SQW edge comes at a multiple of 32768.
+ * The count stands still otherwise.
+ */
+sim_tcnt1_register::operator uint16_t() const
+{
+  static uint16_t count = 0;
+  const uint8_t external_rising = _BV(CS12) | _BV(CS11) | _BV(CS10);
+  if ((TCCR1B & external_rising) == external_rising && rtc_present && (ds3231[SIM_DS3231_STATUS] & SIM_DS3231_EN32KHZ))
+  {
+    count = (now_us - rtc_base_us) * 32768 / 1000000;
+  }
+  return count;
+}
+
+// DS3231 on the TWI bus
+
+sim_twcr_register &sim_twcr_register::operator=(uint8_t value)
+{
+  twi_command(value);
+  return *this;
+}
+
+uint8_t bcd(uint8_t value)
+{
+  return ((value / 10) << 4) | (value % 10);
+}
+
+uint8_t from_bcd(uint8_t value)
+{
+  return (value >> 4) * 10 + (value & 0x0F);
+}
+
+/**
+ * The DS3231 copies its counters into the user registers on START.
+ */
+void ds3231_latch()
+{
+  DateTime time(sim_rtc_unixtime());
+  ds3231[0] = bcd(time.second());
+  ds3231[1] = bcd(time.minute());
+  ds3231[2] = bcd(time.hour());
+  ds3231[4] = bcd(time.day());
+  ds3231[5] = bcd(time.month());
+  ds3231[6] = bcd(time.year() - 2000);
+  ds3231[SIM_DS3231_STATUS] = (ds3231[SIM_DS3231_STATUS] & 0x7F) | (rtc_lost_power ? 0x80 : 0);
+}
+
+/**
+ * Written time takes effect with the STOP, OSF can only be cleared.
+ */
+void ds3231_stop()
+{
+  if (ds3231_time_written)
+  {
+    DateTime time(from_bcd(ds3231[6]) + 2000, from_bcd(ds3231[5] & 0x1F), from_bcd(ds3231[4]),
+                  from_bcd(ds3231[2] & 0x3F), from_bcd(ds3231[1]), from_bcd(ds3231[0]));
+    // writing seconds restarted the countdown chain, SQW follows the new phase
+    sim_set_rtc(time.unixtime(), rtc_lost_power);
+    rtc_base_us = ds3231_seconds_written_us;
+  }
+  if (!(ds3231[SIM_DS3231_STATUS] & 0x80))
+  {
+    rtc_lost_power = false;
+  }
+  ds3231_time_written = false;
+}
+
+/**
+ * A TWCR write with TWINT set starts one bus action, it completes a byte
+ * time later with TWINT and the status the firmware expects.
+ */
+void twi_command(uint8_t value)
+{
+  bool go = value & _BV(TWINT);
+  TWCR.bits = (value & ~_BV(TWINT)) | (go ? 0 : (TWCR.bits & _BV(TWINT)));
+  if (!(value & _BV(TWEN)))
+  {
+    twi_busy = false;
+    twi_bus_owned = false;
+    return;
+  }
+  if (!go)
+  {
+    return;
+  }
+  uint8_t status = TWSR & 0xF8;
+  if (value & _BV(TWSTA))
+  {
+    twi_next_status = twi_bus_owned ? TW_REP_START : TW_START;
+    twi_bus_owned = true;
+    ds3231_latch();
+  }
+  else if (value & _BV(TWSTO))
+  {
+    if (twi_selected)
+    {
+      ds3231_stop();
+      sim_stats.i2c_transactions++;
+    }
+    twi_selected = false;
+    twi_bus_owned = false;
+    TWCR.bits &= ~_BV(TWSTO);
+    return;
+  }
+  else if (status == TW_START || status == TW_REP_START)
+  {
+    twi_selected = rtc_present && (TWDR >> 1) == SIM_DS3231_ADDRESS;
+    twi_master_reading = TWDR & TW_READ;
+    twi_pointer_written = false;
+    if (twi_master_reading)
+    {
+      twi_next_status = twi_selected ? TW_MR_SLA_ACK : TW_MR_SLA_NACK;
+    }
+    else
+    {
+      twi_next_status = twi_selected ? TW_MT_SLA_ACK : TW_MT_SLA_NACK;
+    }
+  }
+  else if (twi_master_reading)
+  {
+    twi_next_data = ds3231[ds3231_pointer];
+    ds3231_pointer = (ds3231_pointer + 1) % SIM_DS3231_REGISTERS;
+    twi_next_status = (value & _BV(TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+  }
+  else
+  {
+    if (!twi_pointer_written)
+    {
+      ds3231_pointer = TWDR % SIM_DS3231_REGISTERS;
+      twi_pointer_written = true;
+    }
+    else
+    {
+      ds3231[ds3231_pointer] = TWDR;
+      ds3231_time_written |= ds3231_pointer <= 6;
+      if (ds3231_pointer == 0)
+      {
+        ds3231_seconds_written_us = now_us + SIM_TWI_BYTE_US;
+      }
+      ds3231_pointer = (ds3231_pointer + 1) % SIM_DS3231_REGISTERS;
+    }
+    twi_next_status = TW_MT_DATA_ACK;
+  }
+  twi_busy = true;
+  twi_done_us = now_us + SIM_TWI_BYTE_US;
+}
+
+void twi_complete()
+{
+  twi_busy = false;
+  TWSR = twi_next_status;
+  if (twi_master_reading && (twi_next_status == TW_MR_DATA_ACK || twi_next_status == TW_MR_DATA_NACK))
+  {
+    TWDR = twi_next_data;
+  }
+  TWCR.bits |= _BV(TWINT);
+  if (TWCR.bits & _BV(TWIE))
+  {
+    TWI_vect();
+  }
+}
+
+// DateTime, civil calendar from days since 1970-01-01
+
+int32_t days_from_civil(int32_t y, uint8_t m, uint8_t d)
+{
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  uint32_t yoe = y - era * 400;
+  uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+void civil_from_days(int32_t z, uint16_t *year, uint8_t *month, uint8_t *day)
+{
+  z += 719468;
+  int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  uint32_t doe = z - era * 146097;
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  *day = doy - (153 * mp + 2) / 5 + 1;
+  *month = mp < 10 ? mp + 3 : mp - 9;
+  *year = yoe + era * 400 + (*month <= 2);
+}
+
+DateTime::DateTime(uint32_t t) : _unixtime(t)
+{
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
+{
+  if (year < 100)
+  {
+    year += 2000;
+  }
+  _unixtime = days_from_civil(year, month, day) * 86400UL + hour * 3600UL + min * 60UL + sec;
+}
+
+DateTime::DateTime(const char *date, const char *time)
+{
+  const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  uint8_t month = 1;
+  for (uint8_t i = 0; i < 12; i++)
+  {
+    if (strncmp(date, months + i * 3, 3) == 0)
+    {
+      month = i + 1;
+    }
+  }
+  *this = DateTime(atoi(date + 7), month, atoi(date + 4), atoi(time), atoi(time + 3), atoi(time + 6));
+}
+
+uint16_t DateTime::year() const
+{
+  uint16_t y;
+  uint8_t m, d;
+  civil_from_days(_unixtime / 86400, &y, &m, &d);
+  return y;
+}
+
+uint8_t DateTime::month() const
+{
+  uint16_t y;
+  uint8_t m, d;
+  civil_from_days(_unixtime / 86400, &y, &m, &d);
+  return m;
+}
+
+uint8_t DateTime::day() const
+{
+  uint16_t y;
+  uint8_t m, d;
+  civil_from_days(_unixtime / 86400, &y, &m, &d);
+  return d;
+}
+
+uint8_t DateTime::hour() const
+{
+  return _unixtime % 86400 / 3600;
+}
+
+uint8_t DateTime::minute() const
+{
+  return _unixtime % 3600 / 60;
+}
+
+uint8_t DateTime::second() const
+{
+  return _unixtime % 60;
+}
+
+void put_two_digits(char *p, uint8_t value)
+{
+  p[0] = '0' + value / 10;
+  p[1] = '0' + value % 10;
+}
+
+char *DateTime::toString(char *buffer) const
+{
+  for (char *p = buffer; *p; p++)
+  {
+    if (strncmp(p, "YYYY", 4) == 0)
+    {
+      put_two_digits(p, year() / 100);
+      put_two_digits(p + 2, year() % 100);
+      p += 3;
+    }
+    else if (strncmp(p, "YY", 2) == 0)
+    {
+      put_two_digits(p++, year() % 100);
+    }
+    else if (strncmp(p, "MM", 2) == 0)
+    {
+      put_two_digits(p++, month());
+    }
+    else if (strncmp(p, "DD", 2) == 0)
+    {
+      put_two_digits(p++, day());
+    }
+    else if (strncmp(p, "hh", 2) == 0)
+    {
+      put_two_digits(p++, hour());
+    }
+    else if (strncmp(p, "mm", 2) == 0)
+    {
+      put_two_digits(p++, minute());
+    }
+    else if (strncmp(p, "ss", 2) == 0)
+    {
+      put_two_digits(p++, second());
+    }
+  }
+  return buffer;
+}
@@ -0,0 +1,55 @@
+#ifndef SIM_HARDWARE_H
+#define SIM_HARDWARE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SIM_PANEL_WIDTH 96
+#define SIM_PANEL_HEIGHT 8
+
+// time one loop() pass takes while awake
+#define SIM_LOOP_COST_US 200
+
+struct sim_counters
+{
+  uint64_t loops;
+  uint64_t sleeps;
+  uint64_t sqw_edges;
+  uint64_t pin_changes;
+  uint64_t i2c_transactions;
+  uint64_t spi_frames;
+  uint64_t spi_bytes;
+  uint64_t eeprom_reads;
+  uint64_t eeprom_writes;
+  uint64_t serial_bytes;
+};
+
+extern sim_counters sim_stats;
+
+uint64_t sim_now_us();
+
+void sim_advance_to(uint64_t time_us);
+
+uint64_t sim_next_event_us();
+
+void sim_drive_pin(uint64_t time_us, uint8_t pin, bool level);
+
+void sim_set_rtc(uint32_t unixtime, bool lost_power);
+
+void sim_set_rtc_present(bool present);
+
+uint32_t sim_rtc_unixtime();
+
+bool sim_panel_pixel(uint8_t x, uint8_t y);
+
+bool sim_eeprom_load(const char *path);
+
+bool sim_eeprom_save(const char *path);
+
+void sim_serial_output(FILE *sink);
+
+void sim_serial_input(const uint8_t *data, size_t size);
+
+void sim_serial_realtime(int fd);
+
+#endif
@@ -0,0 +1,313 @@
+/**
+ * Deterministic accelerated-time simulator of the clock firmware.
+ *
+ *   clock_sim [options]
+ *     --days N / --seconds N   simulated time to run, 1 day by default
+ *     --start UNIX             DS3231 time at power on
+ *     --rtc-lost-power         DS3231 reports lost power at boot
+ *     --script FILE            button trace: "<second> <mode|choose|settings> [clicks|hold <ms>]"
+ *     --snapshots DIR          dump the latched panel as PBM images
+ *     --snapshot-every N       seconds between snapshots, 1 by default
+ *     --eeprom FILE            EEPROM image, loaded at start and saved at exit
+ *     --serial FILE            firmware serial output
+ *     --pty                    run in real time with the serial port on a
+ *                              pseudo terminal, its path is printed at start
+ */
+#include <Arduino.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include "hardware.h"
+
+#define SIM_MODE_PIN 6
+#define SIM_CHOOSE_PIN 7
+#define SIM_SETTINGS_PIN 8
+
+#define SIM_CLICK_PRESS_US 100000
+#define SIM_CLICK_GAP_US 150000
+#define SIM_SNAPSHOT_SCALE 4
+
+struct sim_options
+{
+  uint64_t duration_s = 86400;
+  uint32_t start = 1700000000;
+  bool rtc_lost_power = false;
+  const char *script = NULL;
+  const char *snapshots = NULL;
+  uint64_t snapshot_every = 1;
+  const char *eeprom = NULL;
+  const char *serial = NULL;
+  bool pty = false;
+};
+
+int button_pin(const char *name)
+{
+  if (strcmp(name, "mode") == 0)
+  {
+    return SIM_MODE_PIN;
+  }
+  if (strcmp(name, "choose") == 0)
+  {
+    return SIM_CHOOSE_PIN;
+  }
+  if (strcmp(name, "settings") == 0)
+  {
+    return SIM_SETTINGS_PIN;
+  }
+  return -1;
+}
+
+/**
+ * Turns the button trace into scheduled pin levels, buttons pull pins low.
+ */
+bool load_script(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    fprintf(stderr, "can't open %s\n", path);
+    return false;
+  }
+  char line[128];
+  unsigned number = 0;
+  while (fgets(line, sizeof(line), file))
+  {
+    number++;
+    char *comment = strchr(line, '#');
+    if (comment)
+    {
+      *comment = '\0';
+    }
+    double second;
+    char name[16];
+    char action[16] = "";
+    unsigned value = 1;
+    int fields = sscanf(line, "%lf %15s %15s %u", &second, name, action, &value);
+    if (fields <= 0)
+    {
+      continue;
+    }
+    int pin = fields >= 2 ? button_pin(name) : -1;
+    if (pin < 0)
+    {
+      fprintf(stderr, "%s:%u: expected \"<second> <mode|choose|settings> [clicks|hold <ms>]\"\n", path, number);
+      fclose(file);
+      return false;
+    }
+    uint64_t at = (uint64_t)(second * 1000000);
+    if (strcmp(action, "hold") == 0)
+    {
+      sim_drive_pin(at, pin, LOW);
+      sim_drive_pin(at + value * 1000ULL, pin, HIGH);
+      continue;
+    }
+    unsigned clicks = fields >= 3 ? atoi(action) : 1;
+    for (unsigned i = 0; i < clicks; i++)
+    {
+      sim_drive_pin(at, pin, LOW);
+      sim_drive_pin(at + SIM_CLICK_PRESS_US, pin, HIGH);
+      at += SIM_CLICK_PRESS_US + SIM_CLICK_GAP_US;
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+/**
+ * Writes what the MAX7219 chain latched as a plain PBM image.
+ */
+void write_snapshot(const char *dir, uint64_t second)
+{
+  std::string path = std::string(dir) + "/frame_" + std::to_string(second) + ".pbm";
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file)
+  {
+    return;
+  }
+  fprintf(file, "P1\n%d %d\n", SIM_PANEL_WIDTH * SIM_SNAPSHOT_SCALE, SIM_PANEL_HEIGHT * SIM_SNAPSHOT_SCALE);
+  for (int y = 0; y < SIM_PANEL_HEIGHT * SIM_SNAPSHOT_SCALE; y++)
+  {
+    for (int x = 0; x < SIM_PANEL_WIDTH * SIM_SNAPSHOT_SCALE; x++)
+    {
+      fputc(sim_panel_pixel(x / SIM_SNAPSHOT_SCALE, y / SIM_SNAPSHOT_SCALE) ? '1' : '0', file);
+    }
+    fputc('\n', file);
+  }
+  fclose(file);
+}
+
+bool parse_options(int argc, char **argv, sim_options *options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--rtc-lost-power") == 0)
+    {
+      options->rtc_lost_power = true;
+      continue;
+    }
+    if (strcmp(arg, "--pty") == 0)
+    {
+      options->pty = true;
+      continue;
+    }
+    if (!value)
+    {
+      fprintf(stderr, "unknown option or missing value: %s\n", arg);
+      return false;
+    }
+    i++;
+    if (strcmp(arg, "--days") == 0)
+    {
+      options->duration_s = (uint64_t)(atof(value) * 86400);
+    }
+    else if (strcmp(arg, "--seconds") == 0)
+    {
+      options->duration_s = strtoull(value, NULL, 10);
+    }
+    else if (strcmp(arg, "--start") == 0)
+    {
+      options->start = strtoul(value, NULL, 10);
+    }
+    else if (strcmp(arg, "--script") == 0)
+    {
+      options->script = value;
+    }
+    else if (strcmp(arg, "--snapshots") == 0)
+    {
+      options->snapshots = value;
+    }
+    else if (strcmp(arg, "--snapshot-every") == 0)
+    {
+      options->snapshot_every = strtoull(value, NULL, 10);
+    }
+    else if (strcmp(arg, "--eeprom") == 0)
+    {
+      options->eeprom = value;
+    }
+    else if (strcmp(arg, "--serial") == 0)
+    {
+      options->serial = value;
+    }
+    else
+    {
+      fprintf(stderr, "unknown option: %s\n", arg);
+      return false;
+    }
+  }
+  return options->snapshot_every > 0;
+}
+
+/**
+ * Opens a raw pseudo terminal for the host tools, returns the master or -1.
+ * The slave stays open so the master doesn't hang up between host runs.
+ */
+int open_pty()
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+  {
+    perror("pty");
+    return -1;
+  }
+  const char *name = ptsname(master);
+  int slave = open(name, O_RDWR | O_NOCTTY);
+  if (slave < 0)
+  {
+    perror(name);
+    return -1;
+  }
+  struct termios raw;
+  tcgetattr(slave, &raw);
+  cfmakeraw(&raw);
+  tcsetattr(slave, TCSANOW, &raw);
+  printf("serial port     %s\n", name);
+  fflush(stdout);
+  return master;
+}
+
+void report(const sim_options &options, double wall_s)
+{
+  double simulated_s = sim_now_us() / 1e6;
+  double hours = simulated_s / 3600;
+  printf("simulated       %.0f s in %.3f s wall, %.0f simulated s per wall s\n", simulated_s, wall_s, wall_s > 0 ? simulated_s / wall_s : 0);
+  printf("loop passes     %llu, sleeps %llu\n", (unsigned long long)sim_stats.loops, (unsigned long long)sim_stats.sleeps);
+  printf("SQW edges       %llu, pin changes %llu\n", (unsigned long long)sim_stats.sqw_edges, (unsigned long long)sim_stats.pin_changes);
+  printf("I2C             %llu transactions, %.2f per simulated hour\n", (unsigned long long)sim_stats.i2c_transactions, hours > 0 ? sim_stats.i2c_transactions / hours : 0);
+  printf("SPI             %llu frames, %llu bytes, %.1f bytes per simulated second\n", (unsigned long long)sim_stats.spi_frames, (unsigned long long)sim_stats.spi_bytes, simulated_s > 0 ? sim_stats.spi_bytes / simulated_s : 0);
+  printf("EEPROM          %llu reads, %llu writes\n", (unsigned long long)sim_stats.eeprom_reads, (unsigned long long)sim_stats.eeprom_writes);
+  printf("serial          %llu bytes\n", (unsigned long long)sim_stats.serial_bytes);
+  printf("DS3231          %u at exit\n", sim_rtc_unixtime());
+}
+
+// native tests bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+int main(int argc, char **argv)
+{
+  sim_options options;
+  if (!parse_options(argc, argv, &options))
+  {
+    return 2;
+  }
+  if (options.script && !load_script(options.script))
+  {
+    return 2;
+  }
+  if (options.eeprom)
+  {
+    sim_eeprom_load(options.eeprom);
+  }
+  FILE *serial = NULL;
+  if (options.serial)
+  {
+    serial = fopen(options.serial, "wb");
+    sim_serial_output(serial);
+  }
+  sim_set_rtc(options.start, options.rtc_lost_power);
+  if (options.pty)
+  {
+    int pty = open_pty();
+    if (pty < 0)
+    {
+      return 1;
+    }
+    sim_serial_realtime(pty);
+  }
+
+  std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+  uint64_t end_us = options.duration_s * 1000000;
+  uint64_t next_snapshot = 0;
+
+  setup();
+  while (sim_now_us() < end_us)
+  {
+    loop();
+    sim_stats.loops++;
+    sim_advance_to(sim_now_us() + SIM_LOOP_COST_US);
+
+    if (options.snapshots && sim_now_us() >= next_snapshot * 1000000)
+    {
+      write_snapshot(options.snapshots, next_snapshot);
+      next_snapshot = sim_now_us() / 1000000 / options.snapshot_every * options.snapshot_every + options.snapshot_every;
+    }
+  }
+
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  report(options, wall_s);
+
+  if (options.eeprom)
+  {
+    sim_eeprom_save(options.eeprom);
+  }
+  if (serial)
+  {
+    fclose(serial);
+  }
+  return 0;
+}
+
+#endif
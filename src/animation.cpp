@@ -0,0 +1,170 @@
+#include "animation.h"
+
+static_assert(ANIMATION_TIMER_TOP <= 0xFF, "frame period doesn't fit into Timer2");
+static_assert(MARQUEE_COLUMNS + MARQUEE_GAP <= 0xFF, "marquee positions are 8 bit");
+
+// Timer2 ticks since the last frame, more than one means frames were dropped
+volatile uint8_t animation_ticks = 0;
+animation_kind running_animation = animation_kind::none;
+// frames since the start, the marquee wraps it at the end of every pass
+uint16_t animation_frame = 0;
+bool skip_frame = false;
+animation_stats animation_counters;
+
+// precomputed columns of the marquee text, bit 0 is the top row
+uint8_t marquee_columns[MARQUEE_COLUMNS];
+uint8_t marquee_length = 0;
+
+ISR(TIMER2_COMPA_vect)
+{
+  if (animation_ticks < 0xFF)
+  {
+    animation_ticks++;
+  }
+  power_wake();
+}
+
+/**
+ * Starts frame ticks from frame 0, a running animation is replaced.
+ */
+void animation_start(animation_kind kind)
+{
+  running_animation = kind;
+  animation_frame = 0;
+  skip_frame = false;
+  cli();
+  animation_ticks = 0;
+  sei();
+  TCCR2A = _BV(WGM21);
+  OCR2A = ANIMATION_TIMER_TOP;
+  TCNT2 = 0;
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 = _BV(OCIE2A);
+  TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);
+}
+
+/**
+ * Stops Timer2, so frames don't wake the MCU until the next start.
+ */
+void animation_stop()
+{
+  running_animation = animation_kind::none;
+  TCCR2B = 0;
+  TIMSK2 = 0;
+}
+
+animation_kind animation_running()
+{
+  return running_animation;
+}
+
+/**
+ * Draws the panel wide window of the text, which holds still at its start
+ * and then moves a column per MARQUEE_FRAMES_PER_COLUMN frames.
+ */
+void marquee_draw()
+{
+  uint8_t period = marquee_length + MARQUEE_GAP;
+  uint16_t pass = MARQUEE_HOLD_FRAMES + (uint16_t)period * MARQUEE_FRAMES_PER_COLUMN;
+  while (animation_frame >= pass)
+  {
+    animation_frame -= pass;
+  }
+  uint8_t i = 0;
+  if (animation_frame >= MARQUEE_HOLD_FRAMES)
+  {
+    i = (animation_frame - MARQUEE_HOLD_FRAMES) / MARQUEE_FRAMES_PER_COLUMN;
+  }
+  for (uint8_t x = 0; x < DISPLAY_MODULES * 8; x++)
+  {
+    display_write_column(x, i < marquee_length ? marquee_columns[i] : 0);
+    if (++i == period)
+    {
+      i = 0;
+    }
+  }
+}
+
+/**
+ * Scrolls text which is wider than the panel, until something else is drawn.
+ */
+void marquee_start(const char *text)
+{
+  marquee_length = 0;
+  for (; *text && marquee_length + GLYPH_ADVANCE <= MARQUEE_COLUMNS; text++)
+  {
+    display_rasterize_char(*text, marquee_columns + marquee_length, GLYPH_ADVANCE);
+    marquee_length += GLYPH_ADVANCE;
+  }
+  animation_start(animation_kind::marquee);
+  marquee_draw();
+  display_flip();
+}
+
+/**
+ * Draws the frame which is due, called from the main loop.
+ * Ticks which piled up while the loop was busy are dropped frames, the
+ * animation still moves by wall time. A frame over ANIMATION_BUDGET_US
+ * makes the next one dropped too, so the loop gets its share back.
+ * Returns true when a frame was drawn.
+ */
+bool animation_step()
+{
+  if (running_animation == animation_kind::none)
+  {
+    return false;
+  }
+  cli();
+  uint8_t ticks = animation_ticks;
+  animation_ticks = 0;
+  sei();
+  if (ticks == 0)
+  {
+    return false;
+  }
+  animation_frame += ticks;
+  if (skip_frame)
+  {
+    skip_frame = false;
+    animation_counters.dropped += ticks;
+    return false;
+  }
+  animation_counters.dropped += ticks - 1;
+  animation_counters.frames++;
+
+  PROFILE_SCOPE(ANIMATION_FRAME);
+  uint32_t start = micros();
+  if (running_animation == animation_kind::marquee)
+  {
+    marquee_draw();
+  }
+  else if (running_animation == animation_kind::fraction)
+  {
+    display_fraction(time_base_ticks());
+  }
+  else if (!display_roll(animation_frame < ROLL_FRAMES ? animation_frame : ROLL_FRAMES))
+  {
+    animation_stop();
+  }
+  display_flip();
+
+  uint32_t spent = micros() - start;
+  if (spent > animation_counters.max_us)
+  {
+    animation_counters.max_us = spent > 0xFFFF ? 0xFFFF : spent;
+  }
+  if (spent > ANIMATION_BUDGET_US)
+  {
+    animation_counters.over_budget++;
+    skip_frame = true;
+  }
+  return true;
+}
+
+/**
+ * Drawn and dropped frames since boot, the slowest frame in microseconds.
+ */
+animation_stats get_animation_stats()
+{
+  return animation_counters;
+}
@@ -0,0 +1,61 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include "matrix_display.h"
+#include "digit_renderer.h"
+#include "power.h"
+#include "time_base.h"
+#include "profiler.h"
+
+// Timer2 in CTC mode paces frames, 16 MHz / 1024 / 244 = 64.03 fps
+#define ANIMATION_FPS 64
+#define ANIMATION_TIMER_PRESCALER 1024
+#define ANIMATION_TIMER_TOP (F_CPU / ANIMATION_TIMER_PRESCALER / ANIMATION_FPS - 1)
+// a frame is 15.6 ms, the main loop keeps the rest of it
+#define ANIMATION_BUDGET_US 4000
+
+// text up to 24 glyphs, longer text is cut
+#define MARQUEE_COLUMNS 144
+// blank columns between the end of the text and its next pass
+#define MARQUEE_GAP 24
+// frames per column, 32 px/s
+#define MARQUEE_FRAMES_PER_COLUMN 2
+// the start of the text stands still for a second
+#define MARQUEE_HOLD_FRAMES ANIMATION_FPS
+
+// a digit rolls one row per frame, 125 ms
+#define ROLL_FRAMES ROLL_ROWS
+
+enum animation_kind
+{
+  none = 0,
+  marquee = 1,
+  roll = 2,
+  // the fraction of the second in the fractional display modes
+  fraction = 3
+};
+
+struct animation_stats
+{
+  uint32_t frames;
+  uint32_t dropped;
+  uint32_t over_budget;
+  uint16_t max_us;
+};
+
+void animation_start(animation_kind kind);
+
+void animation_stop();
+
+animation_kind animation_running();
+
+void marquee_start(const char *text);
+
+bool animation_step();
+
+animation_stats get_animation_stats();
+
+#endif
@@ -1,19 +1,65 @@
 #include "application.h"
 
-#define BUTTON_CHANGE_MODE_PIN 6
-#define BUTTON_CHOOSE_PIN 7
-#define BUTTON_SETTINGS_PIN 8
+button mode_btn;
+button choose_btn;
+button settings_btn;
 
-Button mode_btn(BUTTON_CHANGE_MODE_PIN, INPUT_PULLUP, LOW);
-Button choose_btn(BUTTON_CHOOSE_PIN, INPUT_PULLUP, LOW);
-Button settings_btn(BUTTON_SETTINGS_PIN, INPUT_PULLUP, LOW);
-
-uint8_t CURRENT_MODE_INDEX = 0;
-bool trigger_display_update = true;
-int8_t current_timezone = 0;
+volatile bool trigger_display_update = true;
 int8_t epoch_timezone = DEFAULT_TIMEZONE;
-uint32_t epoch_begin_timestamp = 0;
-uint32_t clock_timestamp = 0;
+// UTC date for the string mode and the time editor, follows the time base
+calendar clock_calendar;
+
+// settings menu
+menu_state current_menu = menu_state::closed;
+uint8_t menu_option = NO_ACTION;
+uint32_t menu_seconds = 0;
+uint32_t menu_shown_minute = 0;
+bool menu_redraw = false;
+time_input menu_input;
+
+// serial time sync, a time_set waits for its moment here
+sync_request sync_in;
+bool sync_write_pending = false;
+uint32_t sync_write_time = 0;
+sync_time sync_write_at;
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+/**
+ * A stats record a second at the start of every report period. Sent at once
+ * they fill the TX buffer, and the drift record of a resync on the same
+ * second was dropped.
+ */
+void report_stats()
+{
+  power_stats stats = get_power_stats();
+  switch (stats.seconds % POWER_REPORT_PERIOD)
+  {
+  case 0:
+  {
+    LOG_INFO(POWER_STATS, stats.awake_us, stats.sleeps, stats.seconds);
+    break;
+  }
+  case 1:
+  {
+    animation_stats frames = get_animation_stats();
+    LOG_INFO(ANIMATION_STATS, frames.frames, frames.dropped, frames.max_us);
+    break;
+  }
+  case 2:
+  {
+    button_stats buttons = get_button_stats();
+    LOG_INFO(BUTTON_STATS, buttons.dropped_edges, buttons.click_latency_ms, buttons.max_click_latency_ms);
+    break;
+  }
+  case 3:
+  {
+    memory_stats memory = get_memory_stats();
+    LOG_INFO(MEMORY_STATS, memory.free_now, memory.stack_peak, memory.never_used);
+    break;
+  }
+  }
+}
+#endif
 
 /**
  * Update display info.
@@ -22,33 +68,38 @@ void update_display()
 {
   if (trigger_display_update)
   {
+    PROFILE_SCOPE(UPDATE_DISPLAY);
     trigger_display_update = false;
-    UnixStamp unix_time(rtc.now().unixtime(), current_timezone);
-    display_time(unix_time_to_epoch_time(unix_time, epoch_begin_timestamp), MODE[CURRENT_MODE_INDEX], rtc);
+    display_time(unix_time_to_epoch_time(time_base_now(), settings.epoch_begin), settings.mode_index, &clock_calendar.time);
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    report_stats();
+#endif
   }
 }
 
 /**
- * Changes cyclically date format.
+ * Changes cyclically date format, the choice survives a reboot.
  */
 void display_format_mode_change()
 {
-  if (CURRENT_MODE_INDEX >= 0 && CURRENT_MODE_INDEX < MODE_SIZE - 1)
+  if (settings.mode_index < DISPLAY_MODE_COUNT - 1)
   {
-    CURRENT_MODE_INDEX++;
+    settings.mode_index++;
   }
-  else if (CURRENT_MODE_INDEX == MODE_SIZE - 1)
+  else
   {
-    CURRENT_MODE_INDEX = 0;
+    settings.mode_index = 0;
   }
+  settings_changed(time_base_now());
 }
 
 /**
  * Changes date format by button click.
  */
-void mode_action(Button *btn)
+void mode_action(button *btn)
 {
-  if (btn->hasClicks())
+  if (button_has_clicks(btn))
   {
     display_format_mode_change();
   }
@@ -57,83 +108,80 @@ void mode_action(Button *btn)
 /**
  * SQW signal interruption handler
  *
- * - reads current date from RTC
+ * - advances the time base
  * - sends data to the display handler
  */
 void rtc_interruption_handler()
 {
+  time_base_tick();
   trigger_display_update = true;
+  power_tick();
 }
 
 /**
- * Writes default base timestamp in EEPROM, if it wasn't set previously.
- * Reads base timestamp from EEPROM.
+ * Loads settings, the only EEPROM read of them until reboot.
+ * Finds the newest time checkpoint.
  */
 void setup_from_eeprom()
 {
-  update_eeprom_timestamp(0, EPOCH_BEGIN);
-  
-  // read timezone
-  current_timezone = get_timezone();
-  if (~current_timezone == 0)
-  {
-    debug_output("timezone wasn't set");
-    update_gmt(DEFAULT_TIMEZONE);
-    current_timezone = DEFAULT_TIMEZONE;
-  }
-  // read timestamp for clock
-  clock_timestamp = get_eeprom_timestamp(CLOCK_OFFSET);
-  // read and set epoch begining timestamp
-  epoch_begin_timestamp = get_eeprom_timestamp(EPOCH_BEGIN_OFFSET);
-  if (~epoch_begin_timestamp == 0)
-  {
-    debug_output("begining wasn't set");
-    update_eeprom_timestamp(0, EPOCH_BEGIN);
-    epoch_begin_timestamp = EPOCH_BEGIN;
-  }
-  debug_output("####");
+  settings_load();
+  // the index is into DISPLAY_MODES, which a build may shorten
+  if (settings.mode_index >= DISPLAY_MODE_COUNT)
+  {
+    settings.mode_index = DISPLAY_MODE_DEFAULT;
+  }
+  checkpoint_setup();
+  LOG_DEBUG(EEPROM_DONE);
 }
 
-void edit_current_time() 
+/**
+ * Writes time entered by user to RTC, keeps the entered timezone.
+ */
+bool apply_current_time(uint32_t user_time, uint8_t zone)
 {
-  // convert to unix
-  DateTime now = rtc.now();
-  civil_time current_time = UnixStamp::convertUnixToTime(now.unixtime(), current_timezone);
-  UnixStamp user_time = user_input_time(current_time, current_timezone, &rtc, &settings_btn, &choose_btn, &mode_btn);
   // update rtc clock 
-  DateTime time(user_time.getUnix());
-  rtc.adjust(time);
+  if (!rtc_adjust(user_time))
+  {
+    return false;
+  }
+  time_base_restart(RTC_TIME_WRITE_TAIL_TICKS);
+  time_base_resync();
+  calendar_set(&clock_calendar, time_base_now(), 0);
+  settings.zone = zone;
+  time_zone_select(zone, time_base_now());
+  settings_changed(time_base_now());
   // udpate eeprom for recovery
-  update_eeprom_timestamp(CLOCK_OFFSET, user_time.getUnix());
+  checkpoint_write(user_time);
+  return true;
 }
 
-void edit_epoch()
+void apply_epoch(uint32_t user_input_epoch)
 {
-  uint32_t eeprom_epoch = get_eeprom_timestamp(EPOCH_BEGIN_OFFSET);
-  UnixStamp src_epoch_stamp(eeprom_epoch, current_timezone);
-  debug_output_unixtimestamp(src_epoch_stamp.getUnix());
-  // get time from user
-  UnixStamp user_input_epoch = user_input_time(src_epoch_stamp.getTime(), current_timezone, &rtc, &settings_btn, &choose_btn, &mode_btn);
-  debug_output_unixtimestamp(user_input_epoch.getUnix());
-  // udpate eeprom for recovery
-  update_eeprom_timestamp(EPOCH_BEGIN_OFFSET, user_input_epoch.getUnix());
+  LOG_DEBUG(EPOCH_ENTERED, user_input_epoch);
+  settings.epoch_begin = user_input_epoch;
+  settings_changed(time_base_now());
 }
 
+/**
+ * Starts time input for the chosen option.
+ */
 void menu_action(uint8_t option)
 {
-  debug_output("menu_action");
-  debug_output(option);
+  LOG_DEBUG(MENU_ACTION, option);
 
   switch (option)
   {
   case SET_CURRENT_TIME:
   {
-    edit_current_time();
+    civil_time current_time = UnixStamp::convertUnixToTime(time_zone_local(time_base_now()), 0);
+    user_input_time_begin(&menu_input, current_time, settings.zone);
   }
     break;
   case SET_EPOCH_TIME:
   {
-    edit_epoch();
+    LOG_DEBUG(EPOCH_EDIT, settings.epoch_begin);
+    uint32_t local_epoch = settings.epoch_begin + time_zone_offset_at(settings.zone, settings.epoch_begin);
+    user_input_time_begin(&menu_input, UnixStamp::convertUnixToTime(local_epoch, 0), settings.zone);
   }
     break;  
   default:
@@ -144,80 +192,275 @@ void menu_action(uint8_t option)
   }
 }
 
+/**
+ * Applies time input for the chosen option.
+ */
+void menu_apply(uint8_t option)
+{
+  uint32_t user_time = user_input_time_result(&menu_input);
+  switch (option)
+  {
+  case SET_CURRENT_TIME:
+  {
+    apply_current_time(user_time, menu_input.zone);
+  }
+    break;
+  case SET_EPOCH_TIME:
+  {
+    apply_epoch(user_time);
+  }
+    break;  
+  default:
+    break;
+  }
+}
+
 void display_edit_time() 
 {
-  char date[17] = "YYYY/MM/DD hh:mm";
-  rtc.now().toString(date);
+  char date[DATE_TIME_TEXT_SIZE];
+  format_date_time(date, clock_calendar.time, "// :", true);
   matrix_display_string(date);
 }
 
 void display_edit_epoch()
 {
-  uint32_t epoch = get_eeprom_timestamp(EPOCH_BEGIN_OFFSET);
-  civil_time epoch_civil = UnixStamp::convertUnixToTime(epoch, 0);
-  char *date = (char *)calloc(17, sizeof(char));
-  sprintf(date, "%d/%d/%d %d:%d", epoch_civil.year, epoch_civil.mon, epoch_civil.day, epoch_civil.hour, epoch_civil.min);  
+  civil_time epoch_civil = UnixStamp::convertUnixToTime(settings.epoch_begin, 0);
+  char date[DATE_TIME_TEXT_SIZE];
+  format_date_time(date, epoch_civil, "// :", false);
   matrix_display_string(date);
-  free(date);
 }
 
 /**
- * Setup base time and/or current time.
+ * Shows the chosen option, the current time only changes once a minute.
  */
-uint8_t choose_option(RTC_DS3231 *rtc, Button *choose_btn, Button *settings_btn)
+void display_option()
 {
-  uint32_t menu_seconds = 0;
-  bool should_display_edit_time = true;
-  menu_seconds = rtc->now().secondstime();
-  do
+  uint32_t minute = time_base_now() / 60;
+  if (!menu_redraw && (menu_option != SET_CURRENT_TIME || minute == menu_shown_minute))
+  {
+    return;
+  }
+  menu_redraw = false;
+  menu_shown_minute = minute;
+  if (menu_option == SET_CURRENT_TIME)
+  {
+    display_edit_time();
+  }
+  else
   {
-    choose_btn->clear();
-    settings_btn->clear();
-    choose_btn->tick();
-    settings_btn->tick();
+    display_edit_epoch();
+  }
+}
 
-    if (should_display_edit_time) 
+void close_menu()
+{
+  current_menu = menu_state::closed;
+  // bring the clock face back at once
+  trigger_display_update = true;
+}
+
+/**
+ * Settings menu, stepped from the main loop without blocking it:
+ * settings click -> choose option -> time input -> apply
+ * Returns true while the menu owns the display.
+ */
+bool menu_step(button *choose_btn, button *settings_btn, button *mode_btn)
+{
+  switch (current_menu)
+  {
+  case menu_state::closed:
+  {
+    if (!button_has_clicks(settings_btn))
     {
-      display_edit_time();
-      if (choose_btn->hasClicks())
-      {
-        return SET_CURRENT_TIME;
-      }
-    } 
-    else
+      return false;
+    }
+    LOG_DEBUG(SETTINGS_ACTION);
+    current_menu = menu_state::choosing;
+    menu_option = SET_CURRENT_TIME;
+    menu_seconds = time_base_now();
+    menu_redraw = true;
+    display_option();
+  }
+    break;
+  case menu_state::choosing:
+  {
+    if (button_has_clicks(choose_btn))
     {
-      display_edit_epoch();
-      if (choose_btn->hasClicks())
-      {
-        return SET_EPOCH_TIME;
-      }
+      current_menu = menu_state::editing;
+      menu_action(menu_option);
+      return true;
     }
-
-    if (settings_btn->hasClicks()) 
+    if (button_has_clicks(settings_btn))
+    {
+      menu_option = menu_option == SET_CURRENT_TIME ? SET_EPOCH_TIME : SET_CURRENT_TIME;
+      menu_seconds = time_base_now();
+      menu_redraw = true;
+    }
+    if ((time_base_now() - menu_seconds) >= MENU_THRESSHOLD)
     {
-      should_display_edit_time = !should_display_edit_time;
-      menu_seconds = rtc->now().secondstime();
+      LOG_DEBUG(SETTINGS_NO_ACTION);
+      close_menu();
+      return false;
     }
-  } while ((rtc->now().secondstime() - menu_seconds) < MENU_THRESSHOLD);
-  
-  return NO_ACTION;
+    display_option();
+  }
+    break;
+  case menu_state::editing:
+  {
+    if (user_input_time_step(&menu_input, settings_btn, choose_btn, mode_btn))
+    {
+      menu_apply(menu_option);
+      close_menu();
+      return false;
+    }
+  }
+    break;
+  }
+  return true;
+}
+
+/**
+ * Schedules a time_set: the seconds byte is acknowledged, and the DS3231
+ * second restarts, at the requested time of the time base.
+ */
+uint8_t sync_schedule_write(const uint8_t *payload)
+{
+  if (sync_write_pending)
+  {
+    return sync_status::set_pending;
+  }
+  sync_time at = sync_get_time(payload + 4);
+  if (at.ticks >= TIME_BASE_TICKS_PER_SECOND || at.seconds > time_base_now() + SYNC_SET_AHEAD_SECONDS)
+  {
+    return sync_status::bad_value;
+  }
+  if (at.ticks >= RTC_SECONDS_ACK_TICKS)
+  {
+    at.ticks -= RTC_SECONDS_ACK_TICKS;
+  }
+  else
+  {
+    at.seconds--;
+    at.ticks += TIME_BASE_TICKS_PER_SECOND - RTC_SECONDS_ACK_TICKS;
+  }
+  sync_write_time = sync_get(payload, 4);
+  sync_write_at = at;
+  sync_write_pending = true;
+  return sync_status::accepted;
 }
 
 /**
- * settings_action -> choose_option -> menu_action -> edit_current_time/edit_current_time -> user_input_time
+ * Executes a request of the serial time sync protocol and replies to it,
+ * a time_set replies once the time is written.
  */
-void settings_action(RTC_DS3231 *rtc, Button *choose_btn, Button *settings_btn)
+void sync_action(sync_request *request)
 {
-  if (settings_btn->hasClicks())
+  const uint8_t SIZES[] = {0, 10, 0, 4, 0, 1, 0, 1};
+  uint8_t reply[SYNC_PAYLOAD_MAX - 1];
+  uint8_t *p = reply;
+  uint8_t status = sync_status::accepted;
+  uint8_t command = request->command;
+  if (command < sync_command::time_get || command > sync_command::mode_set)
+  {
+    status = sync_status::unknown_command;
+    command = 0;
+  }
+  else if (request->size != SIZES[command - 1])
+  {
+    status = sync_status::bad_size;
+    command = 0;
+  }
+  uint32_t value = sync_get(request->payload, request->size < 4 ? request->size : 4);
+
+  switch (command)
   {
-    debug_output("settings_action");
-    uint8_t option = choose_option(rtc, choose_btn, settings_btn);
-    if (option == NO_ACTION) {
-      debug_output("settings_action:NO_ACTION");
+  case sync_command::time_get:
+  {
+    p = sync_put_time(p, request->received);
+    // sent, as late as it can be taken
+    p = sync_put_time(p, sync_now());
+  }
+  break;
+  case sync_command::time_set:
+  {
+    status = sync_schedule_write(request->payload);
+    if (status == sync_status::accepted)
+    {
       return;
     }
-    menu_action(option);
   }
+  break;
+  case sync_command::epoch_get:
+  {
+    p = sync_put(p, settings.epoch_begin, 4);
+  }
+  break;
+  case sync_command::epoch_set:
+  {
+    apply_epoch(value);
+    trigger_display_update = true;
+  }
+  break;
+  case sync_command::zone_get:
+  {
+    p = sync_put(p, settings.zone, 1);
+    p = sync_put(p, time_zone_offset_at(settings.zone, time_base_now()) / 60, 2);
+    p = sync_put(p, TIME_ZONE_COUNT, 1);
+  }
+  break;
+  case sync_command::zone_set:
+  {
+    if (value >= TIME_ZONE_COUNT)
+    {
+      status = sync_status::bad_value;
+      break;
+    }
+    settings.zone = value;
+    time_zone_select(settings.zone, time_base_now());
+    settings_changed(time_base_now());
+  }
+  break;
+  case sync_command::mode_get:
+  {
+    p = sync_put(p, settings.mode_index, 1);
+    p = sync_put(p, DISPLAY_MODE_COUNT, 1);
+  }
+  break;
+  case sync_command::mode_set:
+  {
+    if (value >= DISPLAY_MODE_COUNT)
+    {
+      status = sync_status::bad_value;
+      break;
+    }
+    settings.mode_index = value;
+    settings_changed(time_base_now());
+    trigger_display_update = true;
+  }
+  break;
+  default:
+    break;
+  }
+  serial_sync_reply(request->command, status, reply, p - reply);
+}
+
+/**
+ * Writes the time of a pending time_set when its moment comes and replies
+ * with the time base at the start of the write. The loop keeps Timer0
+ * running meanwhile, so it looks every millisecond.
+ */
+void sync_write_step()
+{
+  if (!sync_write_pending || !sync_time_reached(sync_write_at))
+  {
+    return;
+  }
+  sync_write_pending = false;
+  uint8_t reply[6];
+  sync_put_time(reply, sync_now());
+  bool written = apply_current_time(sync_write_time, settings.zone);
+  trigger_display_update = true;
+  serial_sync_reply(sync_command::time_set, written ? sync_status::accepted : sync_status::rtc_failed, reply, sizeof(reply));
 }
 
 void setup_clock_interruption() {
@@ -226,39 +469,67 @@ void setup_clock_interruption() {
   attachInterrupt(digitalPinToInterrupt(CLOCK_INTERRUPT_PIN), rtc_interruption_handler, FALLING);
 }
 
+/**
+ * Button edges are timestamped by pin change interruptions, which wake the
+ * MCU too, debouncing and clicks are decoded in the main loop.
+ */
+void setup_button_interruption() {
+  button_attach(&mode_btn, BUTTON_CHANGE_MODE_PIN);
+  button_attach(&choose_btn, BUTTON_CHOOSE_PIN);
+  button_attach(&settings_btn, BUTTON_SETTINGS_PIN);
+}
+
 void setup_interruptions() {
   setup_clock_interruption();
+  setup_button_interruption();
 }
 
 void setup_app(){
   Serial.begin(9800);
+  PROFILE_SETUP();
   trigger_display_update = true;
-  CURRENT_MODE_INDEX = 0;
-  debug_output("EEPROM setup");
+  LOG_INFO(EEPROM_SETUP);
   setup_from_eeprom();
-  debug_output("start setup");
-  debug_output("display setup");
-  display_setup();
-  debug_output("rtc setup");
+  LOG_INFO(START_SETUP);
+  LOG_INFO(DISPLAY_SETUP);
+  display_setup(settings.brightness);
+  LOG_INFO(RTC_SETUP);
   rtc_setup();
-  debug_output("setup interruptions");
+  time_base_setup();
+  time_base_resync();
+  calendar_set(&clock_calendar, time_base_now(), 0);
+  time_zone_select(settings.zone, time_base_now());
+  LOG_INFO(SETUP_INTERRUPTIONS);
   setup_interruptions();
-  CURRENT_MODE_INDEX = 4;
 
-  debug_output_free_memory("#setup");
+  LOG_INFO(SETUP_FREE_MEMORY, getFreeMemorySize());
 }
 
 void run_app() {
-  mode_btn.clear();
-  choose_btn.clear();
-  mode_btn.tick();
-  choose_btn.tick();
-  settings_btn.clear();
-  settings_btn.tick();
-
-  mode_action(&mode_btn);
-
-  settings_action(&rtc, &choose_btn, &settings_btn);
-  
-  update_display();
+  if (time_base_update())
+  {
+    calendar_advance(&clock_calendar, time_base_now());
+    time_zone_update(time_base_now());
+    checkpoint_update(time_base_now());
+    settings_writeback(time_base_now());
+  }
+  if (serial_sync_receive(&sync_in))
+  {
+    sync_action(&sync_in);
+  }
+  sync_write_step();
+
+  buttons_tick();
+
+  // the mode button decrements values while the menu is open
+  if (!menu_step(&choose_btn, &settings_btn, &mode_btn))
+  {
+    mode_action(&mode_btn);
+    update_display();
+  }
+  animation_step();
+
+  // buttons need millis() while they wait for debounce and click timeouts,
+  // a pending time_set wakes on every Timer0 tick to catch its moment
+  power_sleep(buttons_busy() || sync_write_pending);
 }
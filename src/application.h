@@ -7,28 +7,33 @@
 #include "matrix_display.h"
 #include "user_input.h"
 #include "memory.h"
-
-#define EPOCH_BEGIN 536229000
-#define EPOCH_BEGIN_OFFSET 0
-#define CLOCK_OFFSET 1
-
-#define DEFAULT_TIMEZONE 0
+#include "power.h"
+#include "time_base.h"
+#include "profiler.h"
+#include "checkpoint.h"
+#include "settings.h"
+#include "animation.h"
+#include "buttons.h"
+#include "serial_sync.h"
 
 // menu
 #define NO_ACTION 0
 #define SET_CURRENT_TIME 1
 #define SET_EPOCH_TIME 2
 
+enum menu_state
+{
+  closed = 0,
+  choosing = 1,
+  editing = 2
+};
+
 #define CLOCK_INTERRUPT_PIN 2
 
-const uint8_t MODE[5] = {2, 8, 10, 16, 0};
-const uint8_t MODE_SIZE = 5;
+// seconds between awake/asleep reports in the log
+#define POWER_REPORT_PERIOD 60
 
-extern uint8_t CURRENT_MODE_INDEX;
-extern bool trigger_display_update;
-extern int8_t current_timezone;
-extern uint32_t epoch_begin_timestamp;
-extern uint32_t clock_timestamp;
+extern volatile bool trigger_display_update;
 
 void setup_app();
 
@@ -0,0 +1,228 @@
+#include "buttons.h"
+
+button *attached[BUTTONS_MAX];
+uint8_t attached_count = 0;
+
+// single producer ring: the interruption moves the head, the main loop the tail
+button_edge edge_ring[BUTTON_RING_SIZE];
+volatile uint8_t ring_head = 0;
+volatile uint8_t ring_tail = 0;
+// levels of the newest edge, in the ring or dropped
+uint8_t captured_levels = 0;
+// an edge didn't fit, the loop reads the pins again
+volatile bool levels_lost = false;
+volatile uint16_t dropped_edges = 0;
+uint16_t click_latency_ms = 0;
+uint16_t max_click_latency_ms = 0;
+
+uint8_t read_levels()
+{
+  uint8_t levels = 0;
+  for (uint8_t i = 0; i < attached_count; i++)
+  {
+    if (digitalRead(attached[i]->pin) == LOW)
+    {
+      levels |= 1 << i;
+    }
+  }
+  return levels;
+}
+
+/**
+ * Timestamps the button levels into the ring, an edge which doesn't fit is
+ * counted and the main loop picks the levels up from the pins.
+ */
+void buttons_capture()
+{
+  uint8_t levels = read_levels();
+  if (levels != captured_levels)
+  {
+    uint8_t head = ring_head;
+    uint8_t next = (head + 1) & (BUTTON_RING_SIZE - 1);
+    if (next == ring_tail)
+    {
+      dropped_edges++;
+      levels_lost = true;
+    }
+    else
+    {
+      edge_ring[head].time = millis();
+      edge_ring[head].levels = levels;
+      ring_head = next;
+    }
+    // also after a drop, else an edge back to the old levels is never captured
+    captured_levels = levels;
+  }
+  power_wake();
+}
+
+// port B: D8, port D: D6 and D7
+ISR(PCINT0_vect)
+{
+  buttons_capture();
+}
+
+ISR(PCINT2_vect)
+{
+  buttons_capture();
+}
+
+/**
+ * Button on the pin, shorted to ground when pressed. Its pin change wakes
+ * the MCU and timestamps the edge.
+ */
+void button_attach(button *btn, uint8_t pin)
+{
+  memset(btn, 0, sizeof(*btn));
+  btn->pin = pin;
+  pinMode(pin, INPUT_PULLUP);
+  attached[attached_count++] = btn;
+  power_wake_on_pin(pin);
+}
+
+/**
+ * Applies what was due before the time: the raw level which stayed for
+ * BUTTON_DEBOUNCE_MS, holding and the end of a click series. Changes are
+ * dated by the edges, not by when the loop gets here.
+ */
+void button_settle(button *btn, uint16_t time)
+{
+  if (btn->raw != btn->pressed && (uint16_t)(time - btn->raw_since) >= BUTTON_DEBOUNCE_MS)
+  {
+    btn->pressed = btn->raw;
+    if (btn->pressed)
+    {
+      btn->pressed_since = btn->raw_since;
+    }
+    else
+    {
+      if (!btn->held)
+      {
+        btn->counter++;
+      }
+      btn->held = false;
+      btn->released_since = btn->raw_since;
+    }
+  }
+
+  if (btn->pressed && !btn->held && (uint16_t)(time - btn->pressed_since) >= BUTTON_HOLD_MS)
+  {
+    // a hold isn't a click and ends the series
+    btn->held = true;
+    btn->counter = 0;
+  }
+
+  if (!btn->pressed && btn->counter && (uint16_t)(time - btn->released_since) >= BUTTON_CLICK_MS)
+  {
+    btn->clicks = btn->counter;
+    btn->counter = 0;
+    btn->has_clicks = true;
+  }
+}
+
+void buttons_apply(uint8_t levels, uint16_t time)
+{
+  for (uint8_t i = 0; i < attached_count; i++)
+  {
+    button *btn = attached[i];
+    bool raw = levels & (1 << i);
+    button_settle(btn, time);
+    if (raw != btn->raw)
+    {
+      btn->raw = raw;
+      btn->raw_since = time;
+    }
+  }
+}
+
+/**
+ * Decodes the edges captured since the last call, then the timeouts up to
+ * now. Clicks reported by the previous call are dropped first.
+ */
+void buttons_tick()
+{
+  for (uint8_t i = 0; i < attached_count; i++)
+  {
+    attached[i]->has_clicks = false;
+    attached[i]->clicks = 0;
+  }
+
+  uint8_t tail = ring_tail;
+  while (tail != ring_head)
+  {
+    button_edge edge = edge_ring[tail];
+    tail = (tail + 1) & (BUTTON_RING_SIZE - 1);
+    ring_tail = tail;
+    buttons_apply(edge.levels, edge.time);
+  }
+
+  uint16_t now = millis();
+  if (levels_lost)
+  {
+    levels_lost = false;
+    buttons_apply(read_levels(), now);
+  }
+
+  for (uint8_t i = 0; i < attached_count; i++)
+  {
+    button *btn = attached[i];
+    button_settle(btn, now);
+    if (btn->has_clicks)
+    {
+      click_latency_ms = now - btn->released_since - BUTTON_CLICK_MS;
+      if (click_latency_ms > max_click_latency_ms)
+      {
+        max_click_latency_ms = click_latency_ms;
+      }
+    }
+  }
+}
+
+/**
+ * True while a button is debouncing, down or counting clicks, the decoder
+ * needs millis() to run meanwhile.
+ */
+bool buttons_busy()
+{
+  for (uint8_t i = 0; i < attached_count; i++)
+  {
+    const button *btn = attached[i];
+    if (btn->raw != btn->pressed || btn->pressed || btn->counter)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * A click series ended on the last buttons_tick().
+ */
+bool button_has_clicks(const button *btn)
+{
+  return btn->has_clicks;
+}
+
+/**
+ * Clicks of the series which ended on the last buttons_tick(), 0 otherwise.
+ */
+uint8_t button_clicks(const button *btn)
+{
+  return btn->clicks;
+}
+
+bool button_holding(const button *btn)
+{
+  return btn->held;
+}
+
+button_stats get_button_stats()
+{
+  button_stats stats;
+  cli();
+  stats.dropped_edges = dropped_edges;
+  sei();
+  stats.click_latency_ms = click_latency_ms;
+  stats.max_click_latency_ms = max_click_latency_ms;
+  return stats;
+}
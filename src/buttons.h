@@ -0,0 +1,68 @@
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include "power.h"
+
+#define BUTTON_CHANGE_MODE_PIN 6
+#define BUTTON_CHOOSE_PIN 7
+#define BUTTON_SETTINGS_PIN 8
+
+#define BUTTONS_MAX 3
+// power of two, a bouncing contact fills it in bursts
+#define BUTTON_RING_SIZE 16
+#define BUTTON_DEBOUNCE_MS 50
+// a click series ends after this much time released
+#define BUTTON_CLICK_MS 500
+#define BUTTON_HOLD_MS 600
+
+/**
+ * Debounced state of a button, decoded in the main loop from the edges the
+ * pin change interruption timestamped. Times are the low 16 bits of millis().
+ */
+struct button
+{
+  uint8_t pin;
+  bool raw;
+  bool pressed;
+  bool held;
+  uint16_t raw_since;
+  uint16_t pressed_since;
+  uint16_t released_since;
+  uint8_t counter;
+  uint8_t clicks;
+  bool has_clicks;
+};
+
+struct button_edge
+{
+  uint16_t time;
+  // bit per attached button, set while it is down
+  uint8_t levels;
+};
+
+struct button_stats
+{
+  uint16_t dropped_edges;
+  // how late the loop reported a click series after it was complete
+  uint16_t click_latency_ms;
+  uint16_t max_click_latency_ms;
+};
+
+void button_attach(button *btn, uint8_t pin);
+
+void buttons_tick();
+
+bool buttons_busy();
+
+bool button_has_clicks(const button *btn);
+
+uint8_t button_clicks(const button *btn);
+
+bool button_holding(const button *btn);
+
+button_stats get_button_stats();
+
+#endif
@@ -0,0 +1,112 @@
+#include "calendar.h"
+
+/**
+ * Check leap year
+ */
+bool is_leap_year(int year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+/**
+ * Get max days in monty
+ */
+uint8_t get_days_in_month(uint8_t month, uint16_t year)
+{
+  const uint8_t days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+  if (month == 2 && is_leap_year(year))
+  {
+    return days_in_month[month - 1] + 1;
+  }
+
+  return days_in_month[month - 1];
+}
+
+/**
+ * Days from 1970-01-01 to the date, years since 1970 are counted with
+ * the 400 year cycle shifted to start in March.
+ */
+uint32_t calendar_days(uint16_t year, uint8_t month, uint8_t day)
+{
+  if (month <= 2)
+  {
+    year--;
+  }
+  uint16_t era = year / 400;
+  uint16_t year_of_era = year - era * 400;
+  uint16_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  uint32_t day_of_era = year_of_era * 365UL + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097UL + day_of_era - 719468UL;
+}
+
+/**
+ * Day of the week, 0 is Sunday. 1970-01-01 was a Thursday.
+ */
+uint8_t calendar_weekday(uint32_t days)
+{
+  return (days + 4) % 7;
+}
+
+/**
+ * Full conversion, timezones are whole hours so seconds don't depend on them.
+ */
+void calendar_set(calendar *cal, uint32_t unix_time, int8_t time_zone)
+{
+  cal->time = UnixStamp::convertUnixToTime(unix_time, time_zone);
+  cal->second = unix_time % 60;
+  cal->unix_time = unix_time;
+  cal->time_zone = time_zone;
+}
+
+/**
+ * Carries a second up through the fields, mostly it stops at the first one.
+ */
+void calendar_next_second(calendar *cal)
+{
+  civil_time *time = &cal->time;
+  if (++cal->second < 60)
+  {
+    return;
+  }
+  cal->second = 0;
+  if (++time->min < 60)
+  {
+    return;
+  }
+  time->min = 0;
+  if (++time->hour < 24)
+  {
+    return;
+  }
+  time->hour = 0;
+  if (++time->day <= get_days_in_month(time->mon, time->year))
+  {
+    return;
+  }
+  time->day = 1;
+  if (++time->mon <= 12)
+  {
+    return;
+  }
+  time->mon = 1;
+  time->year++;
+}
+
+/**
+ * Moves the calendar to unix_time, a second at a time. Going back, or
+ * further than CALENDAR_STEP_MAX, is a full conversion.
+ */
+void calendar_advance(calendar *cal, uint32_t unix_time)
+{
+  if (unix_time < cal->unix_time || unix_time - cal->unix_time > CALENDAR_STEP_MAX)
+  {
+    calendar_set(cal, unix_time, cal->time_zone);
+    return;
+  }
+  while (cal->unix_time != unix_time)
+  {
+    calendar_next_second(cal);
+    cal->unix_time++;
+  }
+}
@@ -0,0 +1,34 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <stdint.h>
+#include <UnixStamp.hpp>
+
+// steps back and steps over this many seconds are converted from scratch
+#define CALENDAR_STEP_MAX 255
+
+/**
+ * Civil time which follows unix time second by second, so the date math
+ * of a full conversion only runs on resync and edits.
+ */
+struct calendar
+{
+  civil_time time;
+  uint8_t second;
+  uint32_t unix_time;
+  int8_t time_zone;
+};
+
+bool is_leap_year(int year);
+
+uint8_t get_days_in_month(uint8_t month, uint16_t year);
+
+uint32_t calendar_days(uint16_t year, uint8_t month, uint8_t day);
+
+uint8_t calendar_weekday(uint32_t days);
+
+void calendar_set(calendar *cal, uint32_t unix_time, int8_t time_zone);
+
+void calendar_advance(calendar *cal, uint32_t unix_time);
+
+#endif
@@ -0,0 +1,111 @@
+#include "checkpoint.h"
+
+uint8_t newest_slot = 0;
+uint16_t newest_sequence = 0;
+uint32_t newest_time = 0;
+bool checkpoint_found = false;
+
+uint16_t checkpoint_address(uint8_t slot)
+{
+  return CHECKPOINT_OFFSET + sizeof(checkpoint_record) * slot;
+}
+
+uint8_t checkpoint_crc(const checkpoint_record *record)
+{
+  return storage_crc8(record, offsetof(checkpoint_record, crc)) ^ CHECKPOINT_CRC_XOR;
+}
+
+/**
+ * Reads a record, false if it was never written, was cleared or is torn.
+ */
+bool checkpoint_read(uint8_t slot, checkpoint_record *record)
+{
+  storage_read_block(record, checkpoint_address(slot), sizeof(checkpoint_record));
+  return record->crc == checkpoint_crc(record);
+}
+
+/**
+ * Finds the newest record.
+ * Slots are written in order, so from the anchor slot on they hold
+ * consecutive sequence numbers up to the newest record, followed by the
+ * previous lap, erased or torn records. A binary search finds that edge.
+ * Only the newest write can be torn; when it is slot 0, the previous lap
+ * starts at slot 1.
+ */
+void checkpoint_setup()
+{
+  checkpoint_record record;
+  uint8_t anchor = 0;
+  if (!checkpoint_read(anchor, &record))
+  {
+    anchor = 1;
+    if (!checkpoint_read(anchor, &record))
+    {
+      checkpoint_found = false;
+      return;
+    }
+  }
+  uint16_t first = record.sequence;
+
+  uint8_t low = anchor;
+  uint8_t high = CHECKPOINT_SLOTS - 1;
+  while (low < high)
+  {
+    uint8_t middle = low + (high - low + 1) / 2;
+    if (checkpoint_read(middle, &record) && (uint16_t)(record.sequence - first) == middle - anchor)
+    {
+      low = middle;
+    }
+    else
+    {
+      high = middle - 1;
+    }
+  }
+  checkpoint_read(low, &record);
+  newest_slot = low;
+  newest_sequence = record.sequence;
+  newest_time = record.unix_time;
+  checkpoint_found = true;
+  LOG_INFO(CHECKPOINT_FOUND, newest_time, newest_slot);
+}
+
+/**
+ * Time of the newest checkpoint, false if the ring is empty.
+ */
+bool checkpoint_newest(uint32_t *unix_time)
+{
+  *unix_time = newest_time;
+  return checkpoint_found;
+}
+
+/**
+ * Writes a checkpoint into the slot after the newest one.
+ */
+void checkpoint_write(uint32_t unix_time)
+{
+  checkpoint_record record;
+  record.unix_time = unix_time;
+  record.sequence = checkpoint_found ? newest_sequence + 1 : 0;
+  record.reserved = 0;
+  record.crc = checkpoint_crc(&record);
+
+  uint8_t slot = checkpoint_found ? (newest_slot + 1) % CHECKPOINT_SLOTS : 0;
+  storage_write_block(&record, checkpoint_address(slot), sizeof(checkpoint_record));
+
+  newest_slot = slot;
+  newest_sequence = record.sequence;
+  newest_time = unix_time;
+  checkpoint_found = true;
+}
+
+/**
+ * Writes a checkpoint every CHECKPOINT_MINUTES of running time.
+ */
+void checkpoint_update(uint32_t unix_time)
+{
+  if (checkpoint_found && unix_time - newest_time < CHECKPOINT_MINUTES * 60UL)
+  {
+    return;
+  }
+  checkpoint_write(unix_time);
+}
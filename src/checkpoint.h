@@ -0,0 +1,40 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "storage.h"
+#include "debug_output.h"
+
+// ring of time checkpoints over the EEPROM after the settings area
+#define CHECKPOINT_OFFSET 64
+#define CHECKPOINT_MINUTES 15
+// write cycles a cell is rated for
+#define EEPROM_ENDURANCE 100000UL
+#define CHECKPOINT_LIFETIME_YEARS 100
+// XORed into the CRC, so a zeroed slot doesn't pass as a record at time 0
+#define CHECKPOINT_CRC_XOR 0x55
+
+struct checkpoint_record
+{
+  uint32_t unix_time;
+  uint16_t sequence;
+  uint8_t reserved;
+  uint8_t crc;
+};
+
+const uint8_t CHECKPOINT_SLOTS = (E2END + 1 - CHECKPOINT_OFFSET) / sizeof(checkpoint_record);
+
+// every slot takes one write per lap of the ring
+static_assert((uint64_t)EEPROM_ENDURANCE * CHECKPOINT_SLOTS * CHECKPOINT_MINUTES * 60 / 31536000UL >= CHECKPOINT_LIFETIME_YEARS,
+              "checkpoints wear the EEPROM out too early");
+
+void checkpoint_setup();
+
+bool checkpoint_newest(uint32_t *unix_time);
+
+void checkpoint_write(uint32_t unix_time);
+
+void checkpoint_update(uint32_t unix_time);
+
+#endif
@@ -1,65 +1,52 @@
 #include "debug_output.h"
 
-#define DEBUG false
+uint16_t log_dropped = 0;
 
-void debug_output(const char *msg)
-{   
-  if (DEBUG)
-    Serial.println(msg);
-}
-
-void debug_output(uint32_t num)
+/**
+ * Queues a record into the serial TX buffer, drops it if it doesn't fit,
+ * so logging never waits for the UART.
+ */
+void log_write(uint8_t level, uint8_t id, uint8_t argc, const uint32_t *args)
 {
-  if (DEBUG)
+  uint8_t size = 3 + argc * sizeof(uint32_t);
+  if (Serial.availableForWrite() < size)
   {
-    char *msg = (char *)calloc(12, sizeof(char));
-    sprintf(msg, "%lu", num);
-    Serial.println(msg);
-    free(msg);
+    log_dropped++;
+    return;
   }
+  Serial.write(LOG_SYNC | level);
+  Serial.write(id);
+  Serial.write(argc);
+  // AVR is little endian, arguments go out as they are in memory
+  Serial.write((const uint8_t *)args, argc * sizeof(uint32_t));
 }
 
-void debug_output(int32_t num)
+void log_record(uint8_t level, uint8_t id)
 {
-  if (DEBUG)
-  {
-    char *msg = (char *)calloc(12, sizeof(char));
-    sprintf(msg, "%ld", num);
-    Serial.println(msg);
-    free(msg);
-  }
+  log_write(level, id, 0, NULL);
 }
 
-void debug_output(uint16_t num)
+void log_record(uint8_t level, uint8_t id, uint32_t a)
 {
-  if (DEBUG)
-  {
-    char *msg = (char *)calloc(20, sizeof(char));
-    sprintf(msg, "%d", num);
-    Serial.println(msg);
-    free(msg);
-  }
+  log_write(level, id, 1, &a);
 }
 
-void debug_output(int num)
+void log_record(uint8_t level, uint8_t id, uint32_t a, uint32_t b)
 {
-  if (DEBUG)
-  {
-    char *msg = (char *)calloc(12, sizeof(char));
-    sprintf(msg, "%d", num);
-    Serial.println(msg);
-    free(msg);
-  }
+  uint32_t args[] = {a, b};
+  log_write(level, id, 2, args);
 }
 
-void debug_output_unixtimestamp(UnixStamp unixStamp)
-{  
-  if (DEBUG)
-  {
-    civil_time time = unixStamp.getTime();
-    char *msg = (char *)calloc(32, sizeof(char));
-    sprintf(msg, "%d:%d:%d:%d:%d", time.year, time.mon, time.day, time.hour, time.min);
-    Serial.println(msg);
-    free(msg);
-  }
+void log_record(uint8_t level, uint8_t id, uint32_t a, uint32_t b, uint32_t c)
+{
+  uint32_t args[] = {a, b, c};
+  log_write(level, id, 3, args);
+}
+
+/**
+ * Records which didn't fit into the TX buffer.
+ */
+uint16_t get_log_dropped()
+{
+  return log_dropped;
 }
@@ -1,20 +1,53 @@
 #ifndef DEBUG_OUTPUT_H
 #define DEBUG_OUTPUT_H
 
-#include <stdlib.h>
-#include <stdio.h>
 #include <stdint.h>
 #include <HardwareSerial.h>
-#include <UnixStamp.hpp>
+#include "log_messages.h"
 
-void debug_output(const char *msg);
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
 
-void debug_output(uint32_t num);
+// set by -D LOG_LEVEL=... in build_flags
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_NONE
+#endif
 
-void debug_output(uint16_t num);
+// record: sync | level, id, argc, argc * uint32_t little endian
+#define LOG_SYNC 0xA0
 
-void debug_output(int num);
+/**
+ * LOG_INFO(RTC_SETUP) or LOG_INFO(MENU_ACTION, option).
+ * Calls below LOG_LEVEL compile to nothing, arguments aren't evaluated.
+ */
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(id, ...) log_record(LOG_LEVEL_ERROR, LOG_##id, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(id, ...) do {} while (0)
+#endif
 
-void debug_output_unixtimestamp(UnixStamp unixstamp);
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(id, ...) log_record(LOG_LEVEL_INFO, LOG_##id, ##__VA_ARGS__)
+#else
+#define LOG_INFO(id, ...) do {} while (0)
+#endif
 
-#endif
\ No newline at end of file
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(id, ...) log_record(LOG_LEVEL_DEBUG, LOG_##id, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(id, ...) do {} while (0)
+#endif
+
+void log_record(uint8_t level, uint8_t id);
+
+void log_record(uint8_t level, uint8_t id, uint32_t a);
+
+void log_record(uint8_t level, uint8_t id, uint32_t a, uint32_t b);
+
+void log_record(uint8_t level, uint8_t id, uint32_t a, uint32_t b, uint32_t c);
+
+uint16_t get_log_dropped();
+
+#endif
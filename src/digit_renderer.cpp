@@ -0,0 +1,166 @@
+#include "digit_renderer.h"
+
+const char GLYPHS[] = "0123456789ABCDEF";
+
+// columns of '0'-'F' as the GFX font draws them
+uint8_t glyph_cache[GLYPH_COUNT][GLYPH_WIDTH];
+
+// what is on the display now
+char shown_digits[DIGITS_MAX + 1];
+uint8_t shown_length = 0;
+uint8_t shown_base = 0;
+uint8_t shown_x = 0;
+
+// glyph each position rolls from to its shown digit, GLYPH_NONE when it stands still
+uint8_t rolling_from[DIGITS_MAX];
+bool rolling = false;
+
+uint8_t glyph_index(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  return c - 'A' + 10;
+}
+
+/**
+ * Pre-rasterizes digits, must be called before anything else is drawn.
+ */
+void digit_renderer_setup()
+{
+  for (uint8_t i = 0; i < GLYPH_COUNT; i++)
+  {
+    display_rasterize_char(GLYPHS[i], glyph_cache[i], GLYPH_WIDTH);
+  }
+  digit_renderer_reset();
+}
+
+/**
+ * Forgets displayed digits, the next draw_digits() redraws everything.
+ */
+void digit_renderer_reset()
+{
+  shown_length = 0;
+  shown_base = 0;
+  memset(rolling_from, GLYPH_NONE, sizeof(rolling_from));
+  rolling = false;
+}
+
+/**
+ * Writes value in the base without division, zero padded to width digits.
+ * Returns the length of the text.
+ */
+uint8_t convert_digits(uint32_t value, uint8_t base, uint8_t width, char *text)
+{
+  uint8_t length = base == 16 ? radix_pow2(value, 4, text) : radix_convert(value, base, text);
+  if (length >= width)
+  {
+    return length;
+  }
+  memmove(text + width - length, text, length + 1);
+  memset(text, '0', width - length);
+  return width;
+}
+
+void blit_glyph(uint8_t x, char c)
+{
+  const uint8_t *columns = glyph_cache[glyph_index(c)];
+  for (uint8_t i = 0; i < GLYPH_WIDTH; i++)
+  {
+    display_write_column(x + i, columns[i]);
+  }
+  display_write_column(x + GLYPH_WIDTH, 0);
+}
+
+/**
+ * Draws the rolling glyphs the given rows on their way: the previous glyph
+ * moves up and the shown one comes from below.
+ * Returns false once all of them are in place.
+ */
+bool digit_renderer_roll(uint8_t rows)
+{
+  if (!rolling)
+  {
+    return false;
+  }
+  for (uint8_t i = 0; i < shown_length; i++)
+  {
+    if (rolling_from[i] == GLYPH_NONE)
+    {
+      continue;
+    }
+    const uint8_t *from = glyph_cache[rolling_from[i]];
+    const uint8_t *to = glyph_cache[glyph_index(shown_digits[i])];
+    uint8_t x = shown_x + i * GLYPH_ADVANCE;
+    for (uint8_t col = 0; col < GLYPH_WIDTH; col++)
+    {
+      display_write_column(x + col, (from[col] >> rows) | (to[col] << (ROLL_ROWS - rows)));
+    }
+    if (rows >= ROLL_ROWS)
+    {
+      rolling_from[i] = GLYPH_NONE;
+    }
+  }
+  rolling = rows < ROLL_ROWS;
+  return rolling;
+}
+
+/**
+ * Prints value in base 8, 10 or 16 from x, like print(value, base) does, but redraws only
+ * the glyphs which differ from the previous call. Values shorter than width are zero
+ * padded. With roll the changed glyphs roll in with digit_renderer_roll() when the
+ * layout stays, a roll which is still going is finished first.
+ * Returns true when glyphs started rolling.
+ */
+bool draw_digits(uint32_t value, uint8_t base, uint8_t width, uint8_t x, bool roll)
+{
+  digit_renderer_roll(ROLL_ROWS);
+
+  char digits[DIGITS_MAX + 1];
+  uint8_t length = convert_digits(value, base, width, digits);
+  bool redraw = length != shown_length || base != shown_base || x != shown_x;
+
+  for (uint8_t i = 0; i < length; i++)
+  {
+    if (redraw || (!roll && digits[i] != shown_digits[i]))
+    {
+      blit_glyph(x + i * GLYPH_ADVANCE, digits[i]);
+    }
+    else if (digits[i] != shown_digits[i])
+    {
+      rolling_from[i] = glyph_index(shown_digits[i]);
+      rolling = true;
+    }
+  }
+
+  // a shorter number leaves glyphs of the previous one behind
+  if (x == shown_x)
+  {
+    for (uint8_t col = x + length * GLYPH_ADVANCE; col < x + shown_length * GLYPH_ADVANCE; col++)
+    {
+      display_write_column(col, 0);
+    }
+  }
+
+  memcpy(shown_digits, digits, length + 1);
+  shown_length = length;
+  shown_base = base;
+  shown_x = x;
+  return rolling;
+}
+
+/**
+ * Prints the low width digits of value from x, zero padded. Redraws every
+ * glyph, it is meant for counters which change on every frame.
+ */
+void draw_fixed_digits(uint32_t value, uint8_t base, uint8_t width, uint8_t x)
+{
+  char digits[RADIX_TEXT_SIZE];
+  uint8_t length = convert_digits(value, base, width, digits);
+  const char *low = digits + length - width;
+  for (uint8_t i = 0; i < width; i++)
+  {
+    blit_glyph(x + i * GLYPH_ADVANCE, low[i]);
+  }
+}
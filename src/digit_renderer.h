@@ -0,0 +1,28 @@
+#ifndef DIGIT_RENDERER_H
+#define DIGIT_RENDERER_H
+
+#include <stdint.h>
+#include "matrix_display.h"
+#include "radix.h"
+
+// 5x7 GFX font, one blank column between glyphs
+#define GLYPH_WIDTH 5
+#define GLYPH_ADVANCE 6
+#define GLYPH_COUNT 16
+// 32 bits in octal is the longest string, binary isn't drawn with glyphs
+#define DIGITS_MAX 11
+// a changed glyph rolls up through the 8 rows of the panel
+#define ROLL_ROWS 8
+#define GLYPH_NONE 0xFF
+
+void digit_renderer_setup();
+
+void digit_renderer_reset();
+
+bool draw_digits(uint32_t value, uint8_t base, uint8_t width, uint8_t x, bool roll);
+
+void draw_fixed_digits(uint32_t value, uint8_t base, uint8_t width, uint8_t x);
+
+bool digit_renderer_roll(uint8_t rows);
+
+#endif
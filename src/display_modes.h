@@ -0,0 +1,115 @@
+#ifndef DISPLAY_MODES_H
+#define DISPLAY_MODES_H
+
+#include <stdint.h>
+#include <UnixStamp.hpp>
+
+// modes in the order the mode button cycles them, the types are in
+// matrix_display.cpp; modes left out of the list aren't compiled in
+#ifndef DISPLAY_MODES
+#define DISPLAY_MODES bin_mode, oct_mode, dec_mode, hex_mode, str_mode, bin_fraction_mode, hex_millis_mode
+#endif
+
+// the dispatch is unrolled into the caller, a chain of compares by index
+#define DISPLAY_MODE_INLINE inline __attribute__((always_inline))
+
+/**
+ * Compile-time list of display modes. A mode is a type with:
+ *   static const bool incremental - redrawn over its previous frame
+ *   static const bool fraction - redraws the fraction on animation frames
+ *   static const bool glyphs - draws with the digit renderer, which is set
+ *     up and linked only when a selected mode does
+ *   static bool render(uint32_t seconds, const civil_time *date) - true
+ *     when changed digits should roll
+ *   static void render_fraction(uint16_t ticks)
+ * Indexes past the end of the list do nothing.
+ * index_of<mode>() is the index of the mode, size when it isn't listed.
+ */
+template <typename a, typename b>
+struct same_mode
+{
+  static const bool value = false;
+};
+
+template <typename a>
+struct same_mode<a, a>
+{
+  static const bool value = true;
+};
+
+template <typename... modes>
+struct display_mode_list;
+
+template <>
+struct display_mode_list<>
+{
+  static const uint8_t size = 0;
+  static const bool glyphs = false;
+
+  template <typename wanted>
+  static constexpr uint8_t index_of()
+  {
+    return 0;
+  }
+
+  static DISPLAY_MODE_INLINE bool render(uint8_t index, uint32_t seconds, const civil_time *date)
+  {
+    return false;
+  }
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint8_t index, uint16_t ticks)
+  {
+  }
+
+  static DISPLAY_MODE_INLINE bool incremental(uint8_t index)
+  {
+    return false;
+  }
+
+  static DISPLAY_MODE_INLINE bool fraction(uint8_t index)
+  {
+    return false;
+  }
+};
+
+template <typename mode, typename... rest>
+struct display_mode_list<mode, rest...>
+{
+  typedef display_mode_list<rest...> next;
+
+  static const uint8_t size = 1 + next::size;
+  static const bool glyphs = mode::glyphs || next::glyphs;
+
+  template <typename wanted>
+  static constexpr uint8_t index_of()
+  {
+    return same_mode<mode, wanted>::value ? 0 : 1 + next::template index_of<wanted>();
+  }
+
+  static DISPLAY_MODE_INLINE bool render(uint8_t index, uint32_t seconds, const civil_time *date)
+  {
+    return index == 0 ? mode::render(seconds, date) : next::render(index - 1, seconds, date);
+  }
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint8_t index, uint16_t ticks)
+  {
+    if (index == 0)
+    {
+      mode::render_fraction(ticks);
+      return;
+    }
+    next::render_fraction(index - 1, ticks);
+  }
+
+  static DISPLAY_MODE_INLINE bool incremental(uint8_t index)
+  {
+    return index == 0 ? mode::incremental : next::incremental(index - 1);
+  }
+
+  static DISPLAY_MODE_INLINE bool fraction(uint8_t index)
+  {
+    return index == 0 ? mode::fraction : next::fraction(index - 1);
+  }
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+/**
+ * Log message table, only ids get to the firmware.
+ * tools/log_table.py turns it into the decoder table at build time,
+ * so keep one LOG_MESSAGE per line and append new messages at the end.
+ * Arguments: {u} unsigned, {d} signed, {t} unix timestamp.
+ */
+#define LOG_MESSAGES(LOG_MESSAGE) \
+  LOG_MESSAGE(EEPROM_SETUP, "EEPROM setup") \
+  LOG_MESSAGE(START_SETUP, "start setup") \
+  LOG_MESSAGE(DISPLAY_SETUP, "display setup") \
+  LOG_MESSAGE(RTC_SETUP, "rtc setup") \
+  LOG_MESSAGE(SETUP_INTERRUPTIONS, "setup interruptions") \
+  LOG_MESSAGE(SETUP_FREE_MEMORY, "#setup: {u}") \
+  LOG_MESSAGE(TIMEZONE_NOT_SET, "timezone wasn't set") \
+  LOG_MESSAGE(EPOCH_NOT_SET, "begining wasn't set") \
+  LOG_MESSAGE(EEPROM_DONE, "####") \
+  LOG_MESSAGE(SETTINGS_ACTION, "settings_action") \
+  LOG_MESSAGE(SETTINGS_NO_ACTION, "settings_action:NO_ACTION") \
+  LOG_MESSAGE(MENU_ACTION, "menu_action {u}") \
+  LOG_MESSAGE(EPOCH_EDIT, "epoch {t}") \
+  LOG_MESSAGE(EPOCH_ENTERED, "epoch entered {t}") \
+  LOG_MESSAGE(RTC_NOT_FOUND, "Couldn't connect to the ds3221") \
+  LOG_MESSAGE(RTC_LOST_POWER, "RTC lost power") \
+  LOG_MESSAGE(RTC_RUNNING, "RTC hasnt lost power") \
+  LOG_MESSAGE(TIME_BASE_DRIFT, "time base drift {d} at {d}/4 C") \
+  LOG_MESSAGE(POWER_STATS, "awake us {u} / sleeps {u} / seconds {u}") \
+  LOG_MESSAGE(CHECKPOINT_FOUND, "checkpoint {t} in slot {u}") \
+  LOG_MESSAGE(RTC_RECOVERED, "RTC recovered to {t}") \
+  LOG_MESSAGE(SETTINGS_MIGRATED, "settings migrated from the legacy layout") \
+  LOG_MESSAGE(SETTINGS_SAVED, "settings saved") \
+  LOG_MESSAGE(ANIMATION_STATS, "frames {u} / dropped {u} / slowest {u} us") \
+  LOG_MESSAGE(BUTTON_STATS, "dropped edges {u} / click latency {u} ms, max {u} ms") \
+  LOG_MESSAGE(TIME_ZONE_OFFSET, "zone {u} offset {d} min until {t}") \
+  LOG_MESSAGE(SETTINGS_UPGRADED, "settings upgraded from version {u}") \
+  LOG_MESSAGE(MEMORY_STATS, "free {u} / stack peak {u} / never used {u}")
+
+#define LOG_MESSAGE_ID(id, text) LOG_##id,
+
+enum log_id
+{
+  LOG_MESSAGES(LOG_MESSAGE_ID)
+  LOG_MESSAGE_COUNT
+};
+
+#undef LOG_MESSAGE_ID
+
+#endif
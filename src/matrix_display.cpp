@@ -1,136 +1,530 @@
 #include "matrix_display.h"
-
-enum display_mode
-{
-  bin = 2,
-  oct = 8,
-  dec = 10,
-  hex = 16,
-  str = 0
-};
+#include "digit_renderer.h"
+#include "animation.h"
+#include "text_format.h"
+#include "display_modes.h"
 
 const uint8_t HEIGHT = 3;
 const uint8_t WiDITH = 3;
 const uint8_t DISPLAY_WIDTH = 63;
 
-// 12 matrix in 1 row on D5
-MAX7219<12, 1, 5> mtrx;
+// hex_millis: 8 hex digits of seconds, a dot and 3 hex digits of milliseconds
+const uint8_t MILLIS_SECONDS_DIGITS = 8;
+const uint8_t MILLIS_DIGITS = 3;
+const uint8_t MILLIS_SECONDS_X = 14;
+const uint8_t MILLIS_DOT_X = MILLIS_SECONDS_X + MILLIS_SECONDS_DIGITS * GLYPH_ADVANCE;
+const uint8_t MILLIS_X = MILLIS_DOT_X + 2;
+
+// 12 matrix in 1 row on D10
+MAX7219<DISPLAY_MODULES, 1, DISPLAY_CS_PIN> mtrx;
+
+// copy of what was last latched into the modules, same layout as mtrx.buffer
+uint8_t latched[DISPLAY_MODULES * MAX7219_ROWS];
+update_mode current_update_mode = update_mode::dirty;
+volatile uint32_t spi_bytes_sent = 0;
+
+// mtrx.buffer is the render target, the SPI interruption streams this copy
+uint8_t front[DISPLAY_MODULES * MAX7219_ROWS];
+volatile bool spi_streaming = false;
+bool stream_full = false;
+uint8_t stream_row = 0;
+// register/value pairs of the row on the wire, one per module
+uint8_t row_out[2 * DISPLAY_MODULES];
+uint8_t row_out_index = 0;
+
+// frame buffer layout, learned from mtrx.dot() in calibrate_columns()
+uint8_t column_mask[8];
+uint8_t row_offset[MAX7219_ROWS];
+uint8_t module_origin = 0;
+int8_t module_step = 0;
 
-void display_setup()
+// index of the mode which is currently drawn, digit modes are redrawn incrementally
+uint8_t shown_mode = DISPLAY_MODE_NONE;
+// seconds the fractional modes draw their fraction for
+uint32_t shown_seconds = 0;
+
+/**
+ * Prepares the next row of the front buffer to latch. Modules whose row
+ * didn't change get a no-op, so their registers are left as they are; rows
+ * without changes aren't sent at all unless the whole frame is.
+ * Returns false when the frame is done.
+ */
+bool max7219_next_row()
 {
-  mtrx.begin();
-  mtrx.setBright(15);
+  for (; stream_row < MAX7219_ROWS; stream_row++)
+  {
+    const uint8_t *row_data = front + stream_row * DISPLAY_MODULES;
+    uint8_t *row_latched = latched + stream_row * DISPLAY_MODULES;
+    if (!stream_full && memcmp(row_data, row_latched, DISPLAY_MODULES) == 0)
+    {
+      continue;
+    }
+    for (uint8_t i = 0; i < DISPLAY_MODULES; i++)
+    {
+      if (!stream_full && row_data[i] == row_latched[i])
+      {
+        row_out[2 * i] = MAX7219_NOOP;
+        row_out[2 * i + 1] = 0;
+      }
+      else
+      {
+        // the same digit register order as MAX7219::update()
+        row_out[2 * i] = MAX7219_ROWS - stream_row;
+        row_out[2 * i + 1] = row_data[i];
+        row_latched[i] = row_data[i];
+      }
+    }
+    stream_row++;
+    row_out_index = 0;
+    return true;
+  }
+  return false;
+}
 
-  mtrx.clear();
-  mtrx.update();
+void max7219_send_next()
+{
+  SPDR = row_out[row_out_index++];
+  spi_bytes_sent++;
 }
 
-void matrix_display_string(char *msg)
+/**
+ * A byte is out: send the next one, latch the row with CS once it is
+ * complete and go on with the next changed row.
+ */
+ISR(SPI_STC_vect)
 {
-  mtrx.clear();
-  mtrx.setCursor(0, 0);
-  mtrx.print(msg);
-  mtrx.update();
+  if (row_out_index < sizeof(row_out))
+  {
+    max7219_send_next();
+    return;
+  }
+  digitalWrite(DISPLAY_CS_PIN, HIGH);
+  if (max7219_next_row())
+  {
+    digitalWrite(DISPLAY_CS_PIN, LOW);
+    max7219_send_next();
+    return;
+  }
+  SPCR &= ~_BV(SPIE);
+  spi_streaming = false;
 }
 
 /**
- * Just for fun, writes a sinux graph on the display
-*/
-void graph_sin(uint8_t offset)
+ * Waits until the previous frame is out, a byte time per step.
+ */
+void display_wait()
 {
-  uint8_t x = 0;
-  uint8_t y = 0;
-  mtrx.clear();
-  mtrx.setCursor(0, 0);
-  for (uint8_t i = 0 + offset; i <= 95 + offset; i++)
+  while (spi_streaming)
   {
-    y = 4 * (1 + sinf(25.7 * i));
-    mtrx.dot(x, y);
-    x++;
+    _delay_us(8);
   }
-  mtrx.update();
 }
 
 /**
- * Displays binary date output.
+ * Page flip: hands the rendered frame to the SPI interruption and returns,
+ * drawing into mtrx.buffer can go on meanwhile. The render target keeps its
+ * content, so digit modes keep drawing over the previous frame.
+ * Only waits when the previous frame is still going out.
  */
-void display_bin(uint32_t time)
+void display_flip()
 {
-  const uint8_t START_POSITION = 16;
-  bool bin_time[32];
-  uint8_t x = START_POSITION;
-  uint8_t y = 0;
+  display_wait();
+  memcpy(front, mtrx.buffer, sizeof(front));
+  stream_full = current_update_mode == update_mode::full;
+  stream_row = 0;
+  if (!max7219_next_row())
+  {
+    return;
+  }
+  spi_streaming = true;
+  // 1 MHz, mode 0, MSB first
+  SPSR &= ~_BV(SPI2X);
+  SPCR = _BV(SPIE) | _BV(SPE) | _BV(MSTR) | _BV(SPR0);
+  digitalWrite(DISPLAY_CS_PIN, LOW);
+  max7219_send_next();
+}
+
+void set_update_mode(update_mode mode)
+{
+  current_update_mode = mode;
+}
+
+/**
+ * SPI bytes shifted out to the display since boot or the last reset.
+ */
+uint32_t get_display_bytes_sent()
+{
+  cli();
+  uint32_t sent = spi_bytes_sent;
+  sei();
+  return sent;
+}
+
+void reset_display_bytes_sent()
+{
+  cli();
+  spi_bytes_sent = 0;
+  sei();
+}
 
-  // convert to binary array
-  for (uint8_t i = 0; i < sizeof(uint32_t) * 8; i++)
+/**
+ * Returns index of the single frame buffer byte set by dot(x, y).
+ */
+uint8_t find_dot(int16_t x, int16_t y, uint8_t *mask)
+{
+  mtrx.clear();
+  mtrx.dot(x, y);
+  for (uint8_t i = 0; i < sizeof(mtrx.buffer); i++)
   {
-    uint8_t num = (time >> i) & 1;
-    bin_time[sizeof(uint32_t) * 8 - 1 - i] = num == 1;
+    if (mtrx.buffer[i])
+    {
+      *mask = mtrx.buffer[i];
+      return i;
+    }
   }
+  return 0;
+}
 
-  // print line for 1, rectangle for 0
-  for (uint8_t i = 0; i < sizeof(uint32_t) * 8; i++)
+/**
+ * Learns where columns live in the frame buffer, so they can be written
+ * without going through the per-pixel dot(). Valid while the panel isn't rotated.
+ */
+void calibrate_columns()
+{
+  uint8_t mask;
+  for (uint8_t x = 0; x < 8; x++)
   {
-    bool tmp_bool = bin_time[i];
-    if (tmp_bool)
+    module_origin = find_dot(x, 0, &column_mask[x]);
+  }
+  module_step = find_dot(8, 0, &mask) - module_origin;
+  for (uint8_t y = 0; y < MAX7219_ROWS; y++)
+  {
+    row_offset[y] = find_dot(0, y, &mask) - module_origin;
+  }
+  mtrx.clear();
+}
+
+/**
+ * Writes 8 pixels of the column x, bit 0 is the top row.
+ */
+void display_write_column(uint8_t x, uint8_t column)
+{
+  if (x >= DISPLAY_MODULES * 8)
+  {
+    return;
+  }
+  uint8_t *module = mtrx.buffer + module_origin + (x >> 3) * module_step;
+  uint8_t mask = column_mask[x & 7];
+  for (uint8_t y = 0; y < MAX7219_ROWS; y++)
+  {
+    if (column & 1)
     {
-      mtrx.lineV(x, y, y + HEIGHT - 1);
+      module[row_offset[y]] |= mask;
     }
     else
     {
-      mtrx.rectWH(x, y, WiDITH, HEIGHT, GFX_STROKE);
+      module[row_offset[y]] &= ~mask;
     }
-    x = x + WiDITH + 1;
-    if (x >= DISPLAY_WIDTH + START_POSITION)
+    column >>= 1;
+  }
+}
+
+/**
+ * Reads 8 pixels of the column x, bit 0 is the top row.
+ */
+uint8_t display_read_column(uint8_t x)
+{
+  const uint8_t *module = mtrx.buffer + module_origin + (x >> 3) * module_step;
+  uint8_t mask = column_mask[x & 7];
+  uint8_t column = 0;
+  for (uint8_t y = 0; y < MAX7219_ROWS; y++)
+  {
+    if (module[row_offset[y]] & mask)
     {
-      x = START_POSITION;
-      y = HEIGHT + 1;
+      column |= 1 << y;
     }
   }
+  return column;
+}
+
+/**
+ * Draws a char with the GFX font and reads back its columns.
+ * Destroys the frame buffer content.
+ */
+void display_rasterize_char(char c, uint8_t *columns, uint8_t width)
+{
+  mtrx.clear();
+  mtrx.setCursor(0, 0);
+  mtrx.print(c);
+  for (uint8_t x = 0; x < width; x++)
+  {
+    columns[x] = display_read_column(x);
+  }
+  mtrx.clear();
+}
+
+/**
+ * Marks the frame buffer as foreign, the next display_time() starts from scratch.
+ * Stops the animation which drew it.
+ */
+void display_invalidate()
+{
+  shown_mode = DISPLAY_MODE_NONE;
+  animation_stop();
 }
 
 /**
- * Calls appropriate display function by number system.
+ * Prints the text, text wider than the panel scrolls as a marquee.
  */
-void display_time(uint32_t time_to_display, uint8_t mode, RTC_DS3231 rtc)
+void matrix_display_string(char *msg)
 {
+  display_invalidate();
+  if (strlen(msg) * GLYPH_ADVANCE > DISPLAY_MODULES * 8)
+  {
+    marquee_start(msg);
+    return;
+  }
   mtrx.clear();
   mtrx.setCursor(0, 0);
-  switch (mode)
+  mtrx.print(msg);
+  display_flip();
+}
+
+// two rows of bit cells wrapping at DISPLAY_WIDTH + START_POSITION, 16 per row
+static_assert((DISPLAY_WIDTH + WiDITH) / (WiDITH + 1) == 16, "binary mode expects 16 cells per row");
+static_assert(WiDITH == 3 && HEIGHT == 3, "binary mode columns are precomputed for 3x3 cells");
+
+// columns of 4 bit cells for every nibble, MSB first: line for 1, rectangle for 0
+const uint8_t BIN_NIBBLE_COLUMNS[16][16] PROGMEM = {
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00}, // 0000
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00}, // 0001
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00}, // 0010
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00}, // 0011
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00}, // 0100
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00}, // 0101
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00}, // 0110
+  {0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00}, // 0111
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00}, // 1000
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00}, // 1001
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00}, // 1010
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00}, // 1011
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x05, 0x07, 0x00}, // 1100
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00}, // 1101
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x05, 0x07, 0x00}, // 1110
+  {0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00}, // 1111
+};
+
+/**
+ * Displays binary date output.
+ * The high half-word goes to the top row, the low one to the bottom row,
+ * so every column byte is built from one nibble of each half.
+ */
+void display_bin(uint32_t time)
+{
+  PROFILE_SCOPE(DISPLAY_BIN);
+  const uint8_t START_POSITION = 16;
+  uint16_t top = time >> 16;
+  uint16_t bottom = time & 0xFFFF;
+  uint8_t x = START_POSITION;
+
+  for (uint8_t nibble = 0; nibble < 4; nibble++)
+  {
+    const uint8_t *top_columns = BIN_NIBBLE_COLUMNS[top >> 12];
+    const uint8_t *bottom_columns = BIN_NIBBLE_COLUMNS[bottom >> 12];
+    for (uint8_t i = 0; i < 16; i++)
+    {
+      display_write_column(x++, pgm_read_byte(&top_columns[i]) | pgm_read_byte(&bottom_columns[i]) << (HEIGHT + 1));
+    }
+    top <<= 4;
+    bottom <<= 4;
+  }
+}
+
+/**
+ * Binary seconds.
+ */
+struct bin_mode
+{
+  static const bool incremental = false;
+  static const bool fraction = false;
+  static const bool glyphs = false;
+
+  static DISPLAY_MODE_INLINE bool render(uint32_t seconds, const civil_time *date)
+  {
+    display_bin(seconds);
+    return false;
+  }
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint16_t ticks)
+  {
+  }
+};
+
+/**
+ * Digits in the base from the column x, changed ones roll in.
+ */
+template <uint8_t base, uint8_t x>
+struct digits_mode
+{
+  static const bool incremental = true;
+  static const bool fraction = false;
+  static const bool glyphs = true;
+
+  static DISPLAY_MODE_INLINE bool render(uint32_t seconds, const civil_time *date)
+  {
+    return draw_digits(seconds, base, 0, x, true);
+  }
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint16_t ticks)
+  {
+  }
+};
+
+typedef digits_mode<8, 16> oct_mode;
+typedef digits_mode<10, 16> dec_mode;
+typedef digits_mode<16, 27> hex_mode;
+
+/**
+ * UTC date and time, only for dev and debug.
+ */
+struct str_mode
+{
+  static const bool incremental = false;
+  static const bool fraction = false;
+  static const bool glyphs = false;
+
+  static DISPLAY_MODE_INLINE bool render(uint32_t seconds, const civil_time *date)
+  {
+    char text[DATE_TIME_TEXT_SIZE];
+    format_date_time(text, *date, "::::", true);
+    mtrx.print(text);
+    return false;
+  }
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint16_t ticks)
   {
-  case display_mode::bin:
+  }
+};
+
+/**
+ * 16.16 fixed point binary: seconds on top, the fraction below.
+ */
+struct bin_fraction_mode
+{
+  static const bool incremental = false;
+  static const bool fraction = true;
+  static const bool glyphs = false;
+
+  static DISPLAY_MODE_INLINE bool render(uint32_t seconds, const civil_time *date)
   {
-    display_bin(time_to_display);
+    render_fraction(0);
+    return false;
   }
-  break;
-  case display_mode::oct:
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint16_t ticks)
   {
-    mtrx.setCursor(16, 0);
-    mtrx.print(time_to_display, display_mode::oct);
+    display_bin(shown_seconds << 16 | (uint32_t)ticks << 1);
   }
-  break;
-  case display_mode::dec:
+};
+
+/**
+ * Hex seconds, a dot and 3 hex digits of milliseconds, both zero padded so
+ * the dot keeps its place.
+ */
+struct hex_millis_mode
+{
+  static const bool incremental = true;
+  static const bool fraction = true;
+  static const bool glyphs = true;
+
+  static DISPLAY_MODE_INLINE bool render(uint32_t seconds, const civil_time *date)
   {
-    mtrx.setCursor(16, 0);
-    mtrx.print(time_to_display, display_mode::dec);
+    // the seconds snap, rolling them would hide the running milliseconds
+    draw_digits(seconds, 16, MILLIS_SECONDS_DIGITS, MILLIS_SECONDS_X, false);
+    display_write_column(MILLIS_DOT_X, 0x40);
+    render_fraction(0);
+    return false;
   }
-  break;
-  case display_mode::hex:
+
+  static DISPLAY_MODE_INLINE void render_fraction(uint16_t ticks)
   {
-    mtrx.setCursor(27, 0);
-    mtrx.print(time_to_display, display_mode::hex);
+    draw_fixed_digits(((uint32_t)ticks * 1000) >> 15, 16, MILLIS_DIGITS, MILLIS_X);
   }
-  break;
-  // only for dev and debug
-  case display_mode::str:
+};
+
+typedef display_mode_list<DISPLAY_MODES> selected_modes;
+
+static_assert(selected_modes::size > 0, "DISPLAY_MODES selects no display mode");
+
+const uint8_t DISPLAY_MODE_COUNT = selected_modes::size;
+
+// fresh settings show the date, or the first mode when a build leaves str out
+const uint8_t DISPLAY_MODE_DEFAULT =
+    selected_modes::index_of<str_mode>() < selected_modes::size ? selected_modes::index_of<str_mode>() : 0;
+
+void display_setup(uint8_t brightness)
+{
+  mtrx.begin();
+  mtrx.setBright(brightness);
+
+  calibrate_columns();
+  if (selected_modes::glyphs)
   {
-    char date[17] = "YYYY:MM:DD:hh:mm";
-    rtc.now().toString(date);
-    mtrx.print(date);
+    digit_renderer_setup();
   }
-  break;
-  default:
-    break;
+
+  // the content of the modules is unknown after reset, latch everything once
+  mtrx.clear();
+  set_update_mode(update_mode::full);
+  display_flip();
+  set_update_mode(update_mode::dirty);
+}
+
+/**
+ * Redraws the fraction of the second in the fractional modes, called on
+ * animation frames with 1/32768 s ticks since the shown second began.
+ */
+void display_fraction(uint16_t ticks)
+{
+  selected_modes::render_fraction(shown_mode, ticks);
+}
+
+/**
+ * Moves the rolling digits of the digit modes, false once they are in place.
+ */
+bool display_roll(uint8_t rows)
+{
+  return selected_modes::glyphs && digit_renderer_roll(rows);
+}
+
+/**
+ * Draws the seconds in the mode with the index in DISPLAY_MODES.
+ */
+void display_time(uint32_t time_to_display, uint8_t mode, const civil_time *date)
+{
+  PROFILE_SCOPE(DISPLAY_TIME);
+  bool incremental = mode == shown_mode && selected_modes::incremental(mode);
+  if (!incremental)
+  {
+    animation_stop();
+    mtrx.clear();
+    mtrx.setCursor(0, 0);
+    if (selected_modes::glyphs)
+    {
+      digit_renderer_reset();
+    }
+  }
+  shown_mode = mode;
+  shown_seconds = time_to_display;
+  bool rolling = selected_modes::render(mode, time_to_display, date);
+  display_flip();
+  // changed digits roll in on the following frames, well within the second
+  if (rolling)
+  {
+    animation_start(animation_kind::roll);
+  }
+  if (selected_modes::fraction(mode) && animation_running() != animation_kind::fraction)
+  {
+    animation_start(animation_kind::fraction);
   }
-  mtrx.update();
 }
@@ -4,9 +4,46 @@
 #include <stdint.h>
 #include <WString.h>
 #include <GyverMAX7219.h>
-#include <RTClib.h>
+#include <UnixStamp.hpp>
+#include <SPI.h>
+#include <avr/interrupt.h>
+#include "profiler.h"
 
-void display_setup();
+#define DISPLAY_MODULES 12
+// D10 is the SPI SS pin, D5 is taken by the 32K input of Timer1
+#define DISPLAY_CS_PIN 10
+
+#define MAX7219_ROWS 8
+#define MAX7219_NOOP 0x00
+#define MAX7219_SPI_SPEED 1000000
+
+#define DISPLAY_MODE_NONE 0xFF
+
+enum update_mode
+{
+  full = 0,
+  dirty = 1
+};
+
+void display_setup(uint8_t brightness);
+
+void display_flip();
+
+void display_wait();
+
+void set_update_mode(update_mode mode);
+
+uint32_t get_display_bytes_sent();
+
+void reset_display_bytes_sent();
+
+void display_write_column(uint8_t x, uint8_t column);
+
+uint8_t display_read_column(uint8_t x);
+
+void display_rasterize_char(char c, uint8_t *columns, uint8_t width);
+
+void display_invalidate();
 
 void matrix_display_string(char *msg);
 
@@ -14,10 +51,16 @@ void debug_matrix_output(char *msg, double delay);
 
 void debug_matrix_output(String msg, double delay);
 
-void graph_sin(uint8_t offset);
-
 void display_bin(uint32_t time);
 
-void display_time(uint32_t time_to_display, uint8_t mode, RTC_DS3231 rtc);
+void display_fraction(uint16_t ticks);
+
+bool display_roll(uint8_t rows);
+
+extern const uint8_t DISPLAY_MODE_COUNT;
+
+extern const uint8_t DISPLAY_MODE_DEFAULT;
+
+void display_time(uint32_t time_to_display, uint8_t mode, const civil_time *date);
 
 #endif
\ No newline at end of file
@@ -2,19 +2,50 @@
 
 uint32_t getFreeMemorySize()
 {
+#ifdef __AVR__
     unsigned int v;
     return (unsigned int)&v - (__brkval == 0 ? (unsigned int)&__heap_start : (unsigned int)__brkval);
+#else
+    // no AVR heap in the native simulator
+    return 0;
+#endif
 }
 
-void debug_output_free_memory(const char *label)
+#ifdef __AVR__
+/**
+ * Paints everything above .bss with the canary before main() runs.
+ * The init sections fall through into each other, nothing is on the
+ * stack yet, so the whole of it can be painted.
+ */
+void stack_paint() __attribute__((naked, used, section(".init3")));
+
+void stack_paint()
 {
-    char *msg = (char *)calloc(strlen(label) + 5, sizeof(char));
-    sprintf(msg, "%s: %lu", label, getFreeMemorySize());
-    debug_output(msg);
-    free(msg);
+  uint8_t *p = &_end;
+  while (p <= &__stack)
+  {
+    *p++ = STACK_CANARY;
+  }
 }
+#endif
 
-void debug_output_free_memory()
+/**
+ * Free RAM now and the high-water mark of the stack. The scan goes up from
+ * the heap to the first byte the stack has overwritten.
+ */
+memory_stats get_memory_stats()
 {
-    debug_output(getFreeMemorySize());
+  memory_stats stats = {0, 0, 0};
+#ifdef __AVR__
+  stats.free_now = getFreeMemorySize();
+  const uint8_t *heap_end = __brkval == 0 ? (const uint8_t *)&__heap_start : (const uint8_t *)__brkval;
+  const uint8_t *p = heap_end;
+  while (p <= &__stack && *p == STACK_CANARY)
+  {
+    p++;
+  }
+  stats.never_used = p - heap_end;
+  stats.stack_peak = &__stack - p + 1;
+#endif
+  return stats;
 }
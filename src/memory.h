@@ -2,13 +2,29 @@
 #define NENORY_H
 
 #include <stdint.h>
-#include <string.h>
 #include "debug_output.h"
 
+#ifdef __AVR__
 extern uint32_t __heap_start, *__brkval;
+// the linker symbols of the top of RAM and the end of .bss
+extern uint8_t __stack, _end;
+#endif
+
+// painted over the free RAM at boot, the stack leaves other bytes behind
+#define STACK_CANARY 0xC5
+
+struct memory_stats
+{
+  // bytes between the heap and the stack right now
+  uint16_t free_now;
+  // deepest stack since boot, interrupts included
+  uint16_t stack_peak;
+  // bytes neither the heap nor the stack ever reached
+  uint16_t never_used;
+};
 
 uint32_t getFreeMemorySize(); 
-void debug_output_free_memory();
-void debug_output_free_memory(const char *label);
 
-#endif
\ No newline at end of file
+memory_stats get_memory_stats();
+
+#endif
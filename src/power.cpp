@@ -0,0 +1,88 @@
+#include "power.h"
+
+volatile bool wake_requested = false;
+volatile uint32_t power_seconds = 0;
+uint32_t awake_us = 0;
+uint32_t sleeps = 0;
+uint32_t awake_since = 0;
+
+/**
+ * Enables pin change interrupt on the pin, any edge wakes the MCU.
+ */
+void power_wake_on_pin(uint8_t pin)
+{
+  *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+  *digitalPinToPCICR(pin) |= _BV(digitalPinToPCICRbit(pin));
+}
+
+/**
+ * Called from interruption handlers, the next power_sleep() won't sleep.
+ */
+void power_wake()
+{
+  wake_requested = true;
+}
+
+/**
+ * Called from the 1Hz interruption handler, counts wall time.
+ */
+void power_tick()
+{
+  power_seconds++;
+  wake_requested = true;
+}
+
+// port C pins only wake, buttons on ports B and D have their own handlers
+ISR(PCINT1_vect)
+{
+  power_wake();
+}
+
+/**
+ * Sleeps in idle mode until an interruption.
+ * Without keep_timer the Timer0 overflow is masked too, so only SQW and
+ * pin changes wake the MCU and millis() stands still meanwhile. Keep the
+ * timer while buttons are debouncing or counting clicks.
+ */
+void power_sleep(bool keep_timer)
+{
+  awake_us += micros() - awake_since;
+
+  cli();
+  if (wake_requested)
+  {
+    wake_requested = false;
+    sei();
+    awake_since = micros();
+    return;
+  }
+  if (!keep_timer)
+  {
+    TIMSK0 &= ~_BV(TOIE0);
+  }
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_enable();
+  // interrupts are enabled after the next instruction, so no wake up is lost
+  sei();
+  sleep_cpu();
+  sleep_disable();
+  TIMSK0 |= _BV(TOIE0);
+
+  wake_requested = false;
+  sleeps++;
+  awake_since = micros();
+}
+
+/**
+ * Awake time against wall time counted by SQW, the rest is spent asleep.
+ */
+power_stats get_power_stats()
+{
+  power_stats stats;
+  cli();
+  stats.seconds = power_seconds;
+  sei();
+  stats.awake_us = awake_us;
+  stats.sleeps = sleeps;
+  return stats;
+}
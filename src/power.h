@@ -0,0 +1,27 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include "debug_output.h"
+
+struct power_stats
+{
+  uint32_t awake_us;
+  uint32_t sleeps;
+  uint32_t seconds;
+};
+
+void power_wake_on_pin(uint8_t pin);
+
+void power_wake();
+
+void power_tick();
+
+void power_sleep(bool keep_timer);
+
+power_stats get_power_stats();
+
+#endif
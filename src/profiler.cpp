@@ -0,0 +1,155 @@
+#include "profiler.h"
+#include "radix.h"
+
+#ifdef PROFILE
+
+#define PROFILE_REGION_NAME(region) #region,
+
+const char *const PROFILE_REGION_NAMES[] = {PROFILE_REGIONS(PROFILE_REGION_NAME)};
+
+profile_entry profile_table[PROFILE_REGION_COUNT];
+// cycles an empty scope takes, subtracted from every sample
+uint32_t profiler_overhead = 0;
+
+#ifdef __AVR__
+volatile uint16_t timer1_overflows = 0;
+
+ISR(TIMER1_OVF_vect)
+{
+  timer1_overflows++;
+}
+#endif
+
+/**
+ * Starts Timer1 as a free-running CPU cycle counter.
+ */
+void profiler_setup()
+{
+#ifdef __AVR__
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  TCNT1 = 0;
+  TIMSK1 = _BV(TOIE1);
+#endif
+  profiler_overhead = 0;
+  uint32_t start = profiler_cycles();
+  profiler_overhead = profiler_cycles() - start;
+  profiler_reset();
+}
+
+/**
+ * 32 bit cycle counter, Timer1 and its overflow count.
+ */
+uint32_t profiler_cycles()
+{
+#ifdef __AVR__
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t low = TCNT1;
+  uint16_t high = timer1_overflows;
+  // overflow happened after cli(), its interrupt is still pending
+  if ((TIFR1 & _BV(TOV1)) && low < 0x8000)
+  {
+    high++;
+  }
+  SREG = sreg;
+  return ((uint32_t)high << 16) | low;
+#else
+  return micros() * (F_CPU / 1000000UL);
+#endif
+}
+
+void profiler_record(uint8_t region, uint32_t cycles)
+{
+  profile_entry *entry = &profile_table[region];
+  cycles = cycles > profiler_overhead ? cycles - profiler_overhead : 0;
+  if (cycles < entry->min)
+  {
+    entry->min = cycles;
+  }
+  if (cycles > entry->max)
+  {
+    entry->max = cycles;
+  }
+  entry->sum += cycles;
+  entry->count++;
+}
+
+void profiler_reset()
+{
+  for (uint8_t i = 0; i < PROFILE_REGION_COUNT; i++)
+  {
+    profile_table[i].min = UINT32_MAX;
+    profile_table[i].max = 0;
+    profile_table[i].sum = 0;
+    profile_table[i].count = 0;
+  }
+}
+
+/**
+ * Prints "region count min max mean" in cycles, one region per line.
+ */
+void profiler_dump()
+{
+  Serial.println("region count min max mean");
+  for (uint8_t i = 0; i < PROFILE_REGION_COUNT; i++)
+  {
+    profile_entry *entry = &profile_table[i];
+    Serial.print(PROFILE_REGION_NAMES[i]);
+    Serial.print(' ');
+    Serial.print((unsigned long)entry->count);
+    Serial.print(' ');
+    Serial.print((unsigned long)(entry->count ? entry->min : 0));
+    Serial.print(' ');
+    Serial.print((unsigned long)entry->max);
+    Serial.print(' ');
+    Serial.println((unsigned long)(entry->count ? entry->sum / entry->count : 0));
+  }
+}
+
+/**
+ * Converts a value of every length in base 2, 8, 10 and 16, one sample
+ * each into the RADIX_* regions.
+ */
+void profiler_radix()
+{
+  const uint8_t BASES[] = {2, 8, 10, 16};
+  char text[RADIX_TEXT_SIZE];
+  for (uint8_t i = 0; i < sizeof(BASES); i++)
+  {
+    for (uint8_t bits = 1; bits <= 32; bits++)
+    {
+      uint32_t value = 0xFFFFFFFF >> (32 - bits);
+      uint32_t start = profiler_cycles();
+      radix_convert(value, BASES[i], text);
+      // the text is used, so LTO keeps the conversion
+      asm volatile("" : : "r"(text) : "memory");
+      profiler_record(PROFILE_RADIX_BIN + i, profiler_cycles() - start);
+    }
+  }
+}
+
+/**
+ * 'p' on serial dumps the table, 'r' resets it, 'c' runs profiler_radix().
+ * The serial receiver of the time sync protocol passes on the bytes which
+ * don't start a frame.
+ */
+void profiler_command(uint8_t command)
+{
+  switch (command)
+  {
+  case 'p':
+    profiler_dump();
+    break;
+  case 'r':
+    profiler_reset();
+    break;
+  case 'c':
+    profiler_radix();
+    break;
+  default:
+    break;
+  }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * Instrumented regions, PROFILE_SCOPE(UPDATE_DISPLAY) measures the rest
+ * of the enclosing block.
+ */
+#define PROFILE_REGIONS(PROFILE_REGION) \
+  PROFILE_REGION(UPDATE_DISPLAY) \
+  PROFILE_REGION(DISPLAY_TIME) \
+  PROFILE_REGION(DISPLAY_BIN) \
+  PROFILE_REGION(RTC_NOW) \
+  PROFILE_REGION(USER_INPUT_REDRAW) \
+  PROFILE_REGION(ANIMATION_FRAME) \
+  PROFILE_REGION(RADIX_BIN) \
+  PROFILE_REGION(RADIX_OCT) \
+  PROFILE_REGION(RADIX_DEC) \
+  PROFILE_REGION(RADIX_HEX)
+
+#define PROFILE_REGION_ID(region) PROFILE_##region,
+
+enum profile_region
+{
+  PROFILE_REGIONS(PROFILE_REGION_ID)
+  PROFILE_REGION_COUNT
+};
+
+#undef PROFILE_REGION_ID
+
+// -D PROFILE in build_flags, otherwise markers compile to nothing
+#ifdef PROFILE
+
+struct profile_entry
+{
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t count;
+};
+
+void profiler_setup();
+
+uint32_t profiler_cycles();
+
+void profiler_record(uint8_t region, uint32_t cycles);
+
+void profiler_reset();
+
+void profiler_dump();
+
+void profiler_radix();
+
+void profiler_command(uint8_t command);
+
+class profile_scope
+{
+public:
+  profile_scope(uint8_t region) : _region(region), _start(profiler_cycles()) {}
+  ~profile_scope() { profiler_record(_region, profiler_cycles() - _start); }
+
+private:
+  uint8_t _region;
+  uint32_t _start;
+};
+
+#define PROFILE_SCOPE(region) profile_scope profile_scope_##region(PROFILE_##region)
+#define PROFILE_SETUP() profiler_setup()
+#define PROFILE_COMMAND(command) profiler_command(command)
+
+#else
+
+#define PROFILE_SCOPE(region) do {} while (0)
+#define PROFILE_SETUP() do {} while (0)
+#define PROFILE_COMMAND(command) do {} while (0)
+
+#endif
+
+#endif
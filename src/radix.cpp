@@ -0,0 +1,93 @@
+#include "radix.h"
+
+// upper case, as Print::print(value, base) does
+const char RADIX_DIGITS[] = "0123456789ABCDEF";
+
+/**
+ * Divides by 10 with shifts and adds, AVR has no hardware divider and
+ * the 32 bit division is a long library loop.
+ * The estimate is at most one less than the quotient, the remainder fixes it.
+ */
+uint32_t radix_div10(uint32_t value, uint8_t *remainder)
+{
+  uint32_t q = (value >> 1) + (value >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  uint8_t r = value - ((q << 2) + q) * 2;
+  if (r > 9)
+  {
+    q++;
+    r -= 10;
+  }
+  *remainder = r;
+  return q;
+}
+
+/**
+ * Base 2, 8 or 16 given as shift 1, 3 or 4, digits are just masked bits.
+ * Returns length of the text.
+ */
+uint8_t radix_pow2(uint32_t value, uint8_t shift, char *text)
+{
+  uint8_t mask = (1 << shift) - 1;
+  uint8_t length = 1;
+  for (uint32_t rest = value >> shift; rest; rest >>= shift)
+  {
+    length++;
+  }
+
+  char *p = text + length;
+  *p = '\0';
+  do
+  {
+    *--p = RADIX_DIGITS[value & mask];
+    value >>= shift;
+  } while (p != text);
+  return length;
+}
+
+/**
+ * Base 10 without division. Returns length of the text.
+ */
+uint8_t radix_dec(uint32_t value, char *text)
+{
+  char digits[10];
+  uint8_t length = 0;
+  uint8_t digit;
+  do
+  {
+    value = radix_div10(value, &digit);
+    digits[length++] = '0' + digit;
+  } while (value);
+
+  for (uint8_t i = 0; i < length; i++)
+  {
+    text[i] = digits[length - 1 - i];
+  }
+  text[length] = '\0';
+  return length;
+}
+
+/**
+ * Writes value in base 2, 8, 10 or 16 into text of RADIX_TEXT_SIZE at most.
+ * Returns length of the text, 0 for other bases.
+ */
+uint8_t radix_convert(uint32_t value, uint8_t base, char *text)
+{
+  switch (base)
+  {
+  case 2:
+    return radix_pow2(value, 1, text);
+  case 8:
+    return radix_pow2(value, 3, text);
+  case 10:
+    return radix_dec(value, text);
+  case 16:
+    return radix_pow2(value, 4, text);
+  default:
+    text[0] = '\0';
+    return 0;
+  }
+}
@@ -0,0 +1,17 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdint.h>
+
+// 32 binary digits and the terminating zero
+#define RADIX_TEXT_SIZE 33
+
+uint32_t radix_div10(uint32_t value, uint8_t *remainder);
+
+uint8_t radix_pow2(uint32_t value, uint8_t shift, char *text);
+
+uint8_t radix_dec(uint32_t value, char *text);
+
+uint8_t radix_convert(uint32_t value, uint8_t base, char *text);
+
+#endif
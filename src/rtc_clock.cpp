@@ -1,6 +1,5 @@
 #include "rtc_clock.h"
-
-RTC_DS3231 rtc;
+#include "time_base.h"
 
 /**
  * Converts DateTime to UnixStamp.
@@ -30,49 +29,140 @@ DateTime date_data_to_date_time(DateData date_data)
 }
 
 
-uint32_t unix_time_to_epoch_time(UnixStamp unix_time, uint32_t epoch)
+uint32_t unix_time_to_epoch_time(uint32_t unix_time, uint32_t epoch)
+{
+  return unix_time - epoch;
+}
+
+uint8_t bcd_to_bin(uint8_t value)
+{
+  return (value >> 4) * 10 + (value & 0x0F);
+}
+
+uint8_t bin_to_bcd(uint8_t value)
+{
+  return ((value / 10) << 4) | (value % 10);
+}
+
+/**
+ * Time registers of a burst as unix time.
+ */
+uint32_t rtc_snapshot_unixtime(const rtc_snapshot *snapshot)
+{
+  const uint8_t *registers = snapshot->registers;
+  DateTime time(bcd_to_bin(registers[6]) + 2000, bcd_to_bin(registers[5] & 0x7F), bcd_to_bin(registers[4]),
+                bcd_to_bin(registers[2] & 0x3F), bcd_to_bin(registers[1]), bcd_to_bin(registers[0] & 0x7F));
+  return time.unixtime();
+}
+
+/**
+ * Temperature of a burst in quarters of a degree Celsius.
+ */
+int16_t rtc_snapshot_temperature(const rtc_snapshot *snapshot)
 {
-  return unix_time.getUnix() - epoch;
+  const uint8_t *registers = snapshot->registers;
+  return ((int8_t)registers[DS3231_TEMPERATURE] * 4) | (registers[DS3231_TEMPERATURE + 1] >> 6);
+}
+
+/**
+ * Burst reads the DS3231 and waits for it, for setup and time edits.
+ */
+bool rtc_read(rtc_snapshot *snapshot)
+{
+  // a background read may still be on the bus
+  rtc_twi_wait();
+  if (!rtc_twi_read() || !rtc_twi_wait())
+  {
+    return false;
+  }
+  rtc_twi_snapshot(snapshot);
+  return true;
+}
+
+/**
+ * Sets the DS3231 time and clears the oscillator stopped flag, writing the
+ * seconds restarts the SQW countdown. The 32K output stays on.
+ * The time goes last, so the second restarts RTC_TIME_WRITE_TAIL_TICKS
+ * before this returns.
+ */
+bool rtc_adjust(uint32_t unix_time)
+{
+  DateTime time(unix_time);
+  uint8_t registers[7] = {
+      bin_to_bcd(time.second()), bin_to_bcd(time.minute()), bin_to_bcd(time.hour()),
+      // day of week is not used, any 1..7 will do
+      1, bin_to_bcd(time.day()), bin_to_bcd(time.month()), bin_to_bcd(time.year() - 2000)};
+  rtc_twi_wait();
+  uint8_t status = DS3231_EN32KHZ;
+  if (!rtc_twi_write(DS3231_STATUS, &status, 1) || !rtc_twi_wait())
+  {
+    return false;
+  }
+  return rtc_twi_write(0x00, registers, sizeof(registers)) && rtc_twi_wait();
+}
+
+/**
+ * The newest known time without a running DS3231: the newest checkpoint,
+ * or the build time when there is none or it is older.
+ */
+uint32_t rtc_recovered_time()
+{
+  uint32_t recovered = DateTime(F(__DATE__), F(__TIME__)).unixtime();
+  uint32_t checkpoint;
+  if (checkpoint_newest(&checkpoint) && checkpoint > recovered)
+  {
+    recovered = checkpoint;
+  }
+  return recovered;
 }
 
 /**
  * Setup DS3231:
- * - connect
- * - setup time if power lost
+ * - connect, recovering the bus between a few attempts, without it the
+ *   time base starts from the newest checkpoint
+ * - setup time if power lost, from the newest checkpoint or compile time
  * - clean alarm registers
- * - set 1Hz on SQW pin
+ * - set 1Hz on SQW pin, keep 32.768 kHz on the 32K pin
  * - assign 1Hz interruption handler
  */
 void rtc_setup()
 {
-  // connect via I2C to the ds3221
-  while (!rtc.begin())
+  rtc_twi_setup();
+  rtc_snapshot snapshot;
+  uint8_t attempts = 1;
+  while (!rtc_read(&snapshot))
   {
-    debug_output("Couldn't connect to the ds3221");
-    Serial.flush();
+    LOG_ERROR(RTC_NOT_FOUND);
+    if (attempts++ >= RTC_SETUP_ATTEMPTS)
+    {
+      // no SQW either, the display shows the recovered time until a resync
+      time_base_set(rtc_recovered_time());
+      return;
+    }
+    rtc_twi_recover();
     _delay_ms(10);
   }
 
-  // setup compile time if there were powered off
-  if (rtc.lostPower())
+  // restore the newest known time if there were powered off
+  if (snapshot.registers[DS3231_STATUS] & DS3231_OSF)
   {
-    debug_output("RTC lost power, setup compile time");
-    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+    LOG_INFO(RTC_LOST_POWER);
+    uint32_t recovered = rtc_recovered_time();
+    rtc_adjust(recovered);
+    LOG_INFO(RTC_RECOVERED, recovered);
   }
   else
   {
-    debug_output("RTC hasnt lost power");
+    LOG_INFO(RTC_RUNNING);
   }
 
-  // we don't need the 32K Pin, so disable it
-  rtc.disable32K();
-
-  // clean alarms and disable them, because both registers aren't reset on reboot
-  rtc.clearAlarm(1);
-  rtc.clearAlarm(2);
-  rtc.disableAlarm(1);
-  rtc.disableAlarm(2);
+  // oscillator on, 1Hz on SQW instead of alarm interruptions, both alarms off
+  uint8_t control = 0x00;
+  rtc_twi_write(DS3231_CONTROL, &control, 1);
+  rtc_twi_wait();
 
-  // start oscilaating at SQW with 1Hz
-  rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+  // 32K clocks the sub-second time base, and alarm flags aren't reset on reboot
+  uint8_t status = DS3231_EN32KHZ;
+  rtc_twi_write(DS3231_STATUS, &status, 1);
+  rtc_twi_wait();
 }
\ No newline at end of file
@@ -6,14 +6,24 @@
 #include <stdint.h>
 #include <UnixStamp.hpp>
 #include "debug_output.h"
+#include "checkpoint.h"
+#include "rtc_twi.h"
 
 struct DateData {
     uint32_t timestamp;
     int8_t zone;
 };
 
-// SDA on A4, SCL on A5, SQW on D4
-extern RTC_DS3231 rtc;
+// bursts tried at boot before going on without the DS3231
+#define RTC_SETUP_ATTEMPTS 5
+// the DS3231 restarts its second on the ACK of the seconds byte, 6 bytes
+// of 90 us into rtc_adjust(): the status write, then address, register
+// and the byte
+#define RTC_SECONDS_ACK_TICKS 18
+// the rest of the time write, address to STOP is 9 bytes
+#define RTC_TIME_WRITE_TAIL_TICKS 18
+
+// SDA on A4, SCL on A5, SQW on D2, 32K on D5
 
 UnixStamp date_time_to_unix_time(int8_t gmt, DateTime date_time);
 
@@ -21,7 +31,15 @@ DateTime unix_time_to_date_time(UnixStamp time);
 
 DateTime date_data_to_date_time(DateData date_data);
 
-uint32_t unix_time_to_epoch_time(UnixStamp unix_time, uint32_t epoch);
+uint32_t unix_time_to_epoch_time(uint32_t unix_time, uint32_t epoch);
+
+uint32_t rtc_snapshot_unixtime(const rtc_snapshot *snapshot);
+
+int16_t rtc_snapshot_temperature(const rtc_snapshot *snapshot);
+
+bool rtc_read(rtc_snapshot *snapshot);
+
+bool rtc_adjust(uint32_t unix_time);
 
 void rtc_setup();
 
@@ -0,0 +1,238 @@
+#include "rtc_twi.h"
+
+volatile uint8_t twi_state = rtc_twi_status::idle;
+// register pointer first, then the bytes of a write
+uint8_t twi_out[RTC_TWI_WRITE_MAX];
+uint8_t twi_out_size = 0;
+uint8_t twi_index = 0;
+bool twi_reading = false;
+// seconds the current transaction has been running
+uint8_t twi_busy_ticks = 0;
+
+// the interruption fills the back buffer and flips twi_front when a burst is complete
+rtc_snapshot twi_buffers[2];
+volatile uint8_t twi_front = 0;
+uint8_t twi_sequence = 0;
+rtc_twi_stats twi_stats = {0, 0, 0};
+
+void twi_continue(uint8_t flags)
+{
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | flags;
+}
+
+void twi_stop(uint8_t state)
+{
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+  twi_state = state;
+  if (state == rtc_twi_status::failed)
+  {
+    twi_stats.errors++;
+  }
+}
+
+/**
+ * One step of a transaction per bus event:
+ * START, SLA+W, register pointer, [data | repeated START, SLA+R, burst], STOP
+ */
+ISR(TWI_vect)
+{
+  rtc_snapshot *back = &twi_buffers[twi_front ^ 1];
+  switch (TW_STATUS)
+  {
+  case TW_START:
+    TWDR = (DS3231_ADDRESS << 1) | TW_WRITE;
+    twi_continue(0);
+    break;
+  case TW_REP_START:
+    TWDR = (DS3231_ADDRESS << 1) | TW_READ;
+    twi_continue(0);
+    break;
+  case TW_MT_SLA_ACK:
+  case TW_MT_DATA_ACK:
+    if (twi_index < twi_out_size)
+    {
+      TWDR = twi_out[twi_index++];
+      twi_continue(0);
+    }
+    else if (twi_reading)
+    {
+      twi_index = 0;
+      twi_continue(_BV(TWSTA));
+    }
+    else
+    {
+      twi_stop(rtc_twi_status::done);
+    }
+    break;
+  case TW_MR_SLA_ACK:
+    twi_continue(_BV(TWEA));
+    break;
+  case TW_MR_DATA_ACK:
+    back->registers[twi_index++] = TWDR;
+    // NACK the last byte to end the burst
+    twi_continue(twi_index < DS3231_REGISTERS - 1 ? _BV(TWEA) : 0);
+    break;
+  case TW_MR_DATA_NACK:
+    back->registers[twi_index] = TWDR;
+    twi_sequence = twi_sequence == 0xFF ? 1 : twi_sequence + 1;
+    back->sequence = twi_sequence;
+    twi_front ^= 1;
+    twi_stop(rtc_twi_status::done);
+    break;
+  default:
+    // NACKed address or data, lost arbitration, bus error
+    twi_stop(rtc_twi_status::failed);
+    break;
+  }
+}
+
+/**
+ * TWI master at RTC_TWI_FREQUENCY, the DS3231 board has the pull-ups.
+ */
+void rtc_twi_setup()
+{
+  TWSR = 0;
+  TWBR = (F_CPU / RTC_TWI_FREQUENCY - 16) / 2;
+  TWCR = _BV(TWEN);
+  twi_state = rtc_twi_status::idle;
+}
+
+/**
+ * Starts a transaction once the STOP of the previous one is out. A slave
+ * holding SCL low keeps the STOP from going out: after RTC_TWI_TIMEOUT_MS,
+ * as in rtc_twi_wait(), the bus is recovered and false returned.
+ */
+bool twi_start(bool reading)
+{
+  for (uint16_t waited = 0; TWCR & _BV(TWSTO); waited++)
+  {
+    if (waited >= RTC_TWI_TIMEOUT_MS * 100)
+    {
+      rtc_twi_recover();
+      return false;
+    }
+    _delay_us(10);
+  }
+  twi_reading = reading;
+  twi_index = 0;
+  twi_busy_ticks = 0;
+  twi_state = rtc_twi_status::busy;
+  twi_stats.transactions++;
+  twi_continue(_BV(TWSTA));
+  return true;
+}
+
+/**
+ * Starts a burst read of all registers, false while another transaction
+ * runs or when the bus is stuck.
+ */
+bool rtc_twi_read()
+{
+  if (twi_state == rtc_twi_status::busy)
+  {
+    return false;
+  }
+  twi_out[0] = 0;
+  twi_out_size = 1;
+  return twi_start(true);
+}
+
+/**
+ * Starts writing size bytes from the register address on.
+ */
+bool rtc_twi_write(uint8_t address, const uint8_t *data, uint8_t size)
+{
+  if (twi_state == rtc_twi_status::busy || size > RTC_TWI_WRITE_MAX - 1)
+  {
+    return false;
+  }
+  twi_out[0] = address;
+  memcpy(twi_out + 1, data, size);
+  twi_out_size = size + 1;
+  return twi_start(false);
+}
+
+uint8_t rtc_twi_state()
+{
+  return twi_state;
+}
+
+/**
+ * Waits for the transaction for at most RTC_TWI_TIMEOUT_MS, recovers the
+ * bus when it hangs. Returns true when it went through.
+ */
+bool rtc_twi_wait()
+{
+  for (uint16_t waited = 0; twi_state == rtc_twi_status::busy; waited++)
+  {
+    if (waited >= RTC_TWI_TIMEOUT_MS * 100)
+    {
+      rtc_twi_recover();
+      return false;
+    }
+    _delay_us(10);
+  }
+  return twi_state == rtc_twi_status::done;
+}
+
+/**
+ * Called once a second, a transaction still running on its second tick
+ * hangs: the timer does not run in idle sleep, so seconds are the clock here.
+ */
+void rtc_twi_tick()
+{
+  if (twi_state != rtc_twi_status::busy)
+  {
+    return;
+  }
+  if (++twi_busy_ticks >= 2)
+  {
+    rtc_twi_recover();
+  }
+}
+
+/**
+ * Frees a bus held by a slave stuck mid-byte: clocks SCL until SDA is
+ * released, sends a STOP by hand and restarts the TWI module.
+ */
+void rtc_twi_recover()
+{
+  TWCR = 0;
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+  for (uint8_t i = 0; i < RTC_TWI_RECOVERY_CLOCKS && digitalRead(SDA) == LOW; i++)
+  {
+    digitalWrite(SCL, LOW);
+    pinMode(SCL, OUTPUT);
+    _delay_us(5);
+    pinMode(SCL, INPUT_PULLUP);
+    _delay_us(5);
+  }
+  // SDA rising while SCL is high
+  digitalWrite(SDA, LOW);
+  pinMode(SDA, OUTPUT);
+  _delay_us(5);
+  pinMode(SDA, INPUT_PULLUP);
+  _delay_us(5);
+
+  rtc_twi_setup();
+  twi_state = rtc_twi_status::failed;
+  twi_stats.errors++;
+  twi_stats.recoveries++;
+}
+
+/**
+ * Copies the newest burst, returns its sequence or 0 if there is none yet.
+ * Transactions are only started from the main loop, so the front buffer is
+ * not written while it is copied here.
+ */
+uint8_t rtc_twi_snapshot(rtc_snapshot *snapshot)
+{
+  *snapshot = twi_buffers[twi_front];
+  return snapshot->sequence;
+}
+
+rtc_twi_stats get_rtc_twi_stats()
+{
+  return twi_stats;
+}
@@ -0,0 +1,67 @@
+#ifndef RTC_TWI_H
+#define RTC_TWI_H
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
+#include <stdint.h>
+
+#define DS3231_ADDRESS 0x68
+// time, alarms, control, status, aging and temperature, read in one burst
+#define DS3231_REGISTERS 0x13
+#define DS3231_CONTROL 0x0E
+#define DS3231_STATUS 0x0F
+#define DS3231_TEMPERATURE 0x11
+// oscillator stopped flag of the status register
+#define DS3231_OSF 0x80
+// 32.768 kHz output enable of the status register
+#define DS3231_EN32KHZ 0x08
+
+#define RTC_TWI_FREQUENCY 100000UL
+// longest write: register pointer and the 7 time registers
+#define RTC_TWI_WRITE_MAX 8
+// a 19 byte burst takes about 2 ms at 100 kHz
+#define RTC_TWI_TIMEOUT_MS 25
+#define RTC_TWI_RECOVERY_CLOCKS 9
+
+enum rtc_twi_status
+{
+  idle = 0,
+  busy = 1,
+  done = 2,
+  failed = 3
+};
+
+struct rtc_snapshot
+{
+  uint8_t registers[DS3231_REGISTERS];
+  // counts published bursts, 0 before the first one
+  uint8_t sequence;
+};
+
+struct rtc_twi_stats
+{
+  uint16_t transactions;
+  uint16_t errors;
+  uint16_t recoveries;
+};
+
+void rtc_twi_setup();
+
+bool rtc_twi_read();
+
+bool rtc_twi_write(uint8_t address, const uint8_t *data, uint8_t size);
+
+uint8_t rtc_twi_state();
+
+bool rtc_twi_wait();
+
+void rtc_twi_tick();
+
+void rtc_twi_recover();
+
+uint8_t rtc_twi_snapshot(rtc_snapshot *snapshot);
+
+rtc_twi_stats get_rtc_twi_stats();
+
+#endif
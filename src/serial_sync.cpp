@@ -0,0 +1,133 @@
+#include "serial_sync.h"
+
+// command, size, payload and CRC of the frame being received
+uint8_t sync_frame[3 + SYNC_PAYLOAD_MAX];
+uint8_t sync_frame_size = 0;
+bool sync_receiving = false;
+uint32_t sync_frame_since = 0;
+
+/**
+ * Time base now, the ticks hold at the end of a second whose edge isn't
+ * applied yet, so the pair never runs backwards.
+ */
+sync_time sync_now()
+{
+  sync_time now;
+  now.seconds = time_base_now();
+  now.ticks = time_base_ticks();
+  return now;
+}
+
+bool sync_time_reached(sync_time time)
+{
+  uint32_t now = time_base_now();
+  return now > time.seconds || (now == time.seconds && time_base_ticks() >= time.ticks);
+}
+
+/**
+ * Little endian, as the AVR keeps it and the host tools read it.
+ */
+uint8_t *sync_put(uint8_t *p, uint32_t value, uint8_t size)
+{
+  for (uint8_t i = 0; i < size; i++)
+  {
+    *p++ = value;
+    value >>= 8;
+  }
+  return p;
+}
+
+uint32_t sync_get(const uint8_t *p, uint8_t size)
+{
+  uint32_t value = 0;
+  for (uint8_t i = size; i > 0; i--)
+  {
+    value = value << 8 | p[i - 1];
+  }
+  return value;
+}
+
+uint8_t *sync_put_time(uint8_t *p, sync_time time)
+{
+  p = sync_put(p, time.seconds, 4);
+  return sync_put(p, time.ticks, 2);
+}
+
+sync_time sync_get_time(const uint8_t *p)
+{
+  sync_time time;
+  time.seconds = sync_get(p, 4);
+  time.ticks = sync_get(p + 4, 2);
+  return time;
+}
+
+/**
+ * Takes the received bytes, returns true with a complete frame with a good
+ * CRC. Bad frames are answered here. Bytes outside frames are profiler
+ * commands.
+ */
+bool serial_sync_receive(sync_request *request)
+{
+  if (sync_receiving && time_base_now() - sync_frame_since > SYNC_FRAME_SECONDS)
+  {
+    sync_receiving = false;
+  }
+  while (Serial.available() > 0)
+  {
+    uint8_t c = Serial.read();
+    if (!sync_receiving)
+    {
+      if (c == SYNC_FRAME)
+      {
+        sync_receiving = true;
+        sync_frame_size = 0;
+        sync_frame_since = time_base_now();
+      }
+      else
+      {
+        PROFILE_COMMAND(c);
+      }
+      continue;
+    }
+    sync_frame[sync_frame_size++] = c;
+    if (sync_frame_size == 2 && sync_frame[1] > SYNC_PAYLOAD_MAX)
+    {
+      sync_receiving = false;
+      serial_sync_reply(sync_frame[0], sync_status::bad_size, NULL, 0);
+      continue;
+    }
+    if (sync_frame_size < 2 || sync_frame_size < 3 + sync_frame[1])
+    {
+      continue;
+    }
+    sync_receiving = false;
+    uint8_t size = sync_frame[1];
+    if (storage_crc8(sync_frame, 2 + size) != sync_frame[2 + size])
+    {
+      serial_sync_reply(sync_frame[0], sync_status::bad_crc, NULL, 0);
+      continue;
+    }
+    request->received = sync_now();
+    request->command = sync_frame[0];
+    request->size = size;
+    memcpy(request->payload, sync_frame + 2, size);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Sends the reply frame, it waits for room in the TX buffer. The payload
+ * takes SYNC_PAYLOAD_MAX - 1 bytes at most, after the status.
+ */
+void serial_sync_reply(uint8_t command, uint8_t status, const uint8_t *payload, uint8_t size)
+{
+  uint8_t frame[2 + SYNC_PAYLOAD_MAX];
+  frame[0] = command | SYNC_REPLY;
+  frame[1] = size + 1;
+  frame[2] = status;
+  memcpy(frame + 3, payload, size);
+  Serial.write(SYNC_FRAME);
+  Serial.write(frame, size + 3);
+  Serial.write(storage_crc8(frame, size + 3));
+}
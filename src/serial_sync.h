@@ -0,0 +1,85 @@
+#ifndef SERIAL_SYNC_H
+#define SERIAL_SYNC_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "time_base.h"
+#include "storage.h"
+#include "profiler.h"
+
+// frames both ways: SYNC_FRAME, command, size, payload, CRC-8 of command to payload;
+// log records start with 0xA1..0xA3, so a reader tells them apart by the first byte
+#define SYNC_FRAME 0xB5
+// set in the command of replies, their payload starts with a sync_status
+#define SYNC_REPLY 0x80
+// a time_get reply: status and two sync_time
+#define SYNC_PAYLOAD_MAX 13
+// a frame not complete within this many seconds is dropped
+#define SYNC_FRAME_SECONDS 2
+// a time_set waits at most this far ahead
+#define SYNC_SET_AHEAD_SECONDS 10
+
+enum sync_command
+{
+  // -> received and sent sync_time, in the DS3231 time base
+  time_get = 0x01,
+  // uint32 unix time, sync_time to write it at -> sync_time it was written
+  time_set = 0x02,
+  epoch_get = 0x03,
+  epoch_set = 0x04,
+  // -> zone, offset in minutes, zone count
+  zone_get = 0x05,
+  zone_set = 0x06,
+  // -> mode index, mode count
+  mode_get = 0x07,
+  mode_set = 0x08
+};
+
+enum sync_status
+{
+  accepted = 0,
+  bad_crc = 1,
+  unknown_command = 2,
+  bad_size = 3,
+  bad_value = 4,
+  rtc_failed = 5,
+  // a time_set is already waiting
+  set_pending = 6
+};
+
+/**
+ * Device time: unix seconds and 1/32768 s ticks of the second.
+ * The ticks are 0 while the 32K count isn't locked, and in PROFILE builds.
+ */
+struct sync_time
+{
+  uint32_t seconds;
+  uint16_t ticks;
+};
+
+struct sync_request
+{
+  uint8_t command;
+  uint8_t size;
+  uint8_t payload[SYNC_PAYLOAD_MAX];
+  // when the last byte of the frame was taken
+  sync_time received;
+};
+
+sync_time sync_now();
+
+bool sync_time_reached(sync_time time);
+
+bool serial_sync_receive(sync_request *request);
+
+void serial_sync_reply(uint8_t command, uint8_t status, const uint8_t *payload, uint8_t size);
+
+uint8_t *sync_put(uint8_t *p, uint32_t value, uint8_t size);
+
+uint32_t sync_get(const uint8_t *p, uint8_t size);
+
+uint8_t *sync_put_time(uint8_t *p, sync_time time);
+
+sync_time sync_get_time(const uint8_t *p);
+
+#endif
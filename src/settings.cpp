@@ -0,0 +1,98 @@
+#include "settings.h"
+
+// RAM copy of the stored settings, the only one the firmware reads
+settings_data settings;
+bool settings_dirty = false;
+uint32_t settings_changed_at = 0;
+
+// stored bytes, without the padding a host build adds
+const uint8_t SETTINGS_SIZE = offsetof(settings_data, crc) + 1;
+
+uint8_t settings_crc(const settings_data *data)
+{
+  return storage_crc8(data, offsetof(settings_data, crc));
+}
+
+void settings_save()
+{
+  settings.crc = settings_crc(&settings);
+  storage_write_block(&settings, SETTINGS_OFFSET, SETTINGS_SIZE);
+  settings_dirty = false;
+  LOG_DEBUG(SETTINGS_SAVED);
+}
+
+/**
+ * Builds settings from the layout before versioning:
+ * timezone byte at EEPROM_GMT_OFFSET, epoch begin at timestamp index 0,
+ * erased cells meaning "not set".
+ */
+void settings_migrate_legacy()
+{
+  settings.version = SETTINGS_VERSION;
+  settings.mode_index = DISPLAY_MODE_DEFAULT;
+  settings.brightness = DEFAULT_BRIGHTNESS;
+
+  int8_t timezone = get_timezone();
+  if ((uint8_t)timezone == 0xFF)
+  {
+    LOG_INFO(TIMEZONE_NOT_SET);
+    timezone = DEFAULT_TIMEZONE;
+  }
+  settings.zone = time_zone_from_hours(timezone);
+  settings.epoch_begin = get_eeprom_timestamp(0);
+  if (settings.epoch_begin == 0xFFFFFFFF)
+  {
+    LOG_INFO(EPOCH_NOT_SET);
+    settings.epoch_begin = EPOCH_BEGIN;
+  }
+  LOG_INFO(SETTINGS_MIGRATED);
+}
+
+/**
+ * Loads the settings once at boot.
+ * A version 1 record gets the zone of its offset, a record with a bad CRC
+ * or an unknown version falls back to the legacy layout; the result is
+ * written back right away.
+ */
+void settings_load()
+{
+  storage_read_block(&settings, SETTINGS_OFFSET, SETTINGS_SIZE);
+  bool valid = settings.crc == settings_crc(&settings);
+  if (valid && settings.version == SETTINGS_VERSION)
+  {
+    return;
+  }
+  if (valid && settings.version == 1)
+  {
+    settings.version = SETTINGS_VERSION;
+    settings.zone = time_zone_from_hours((int8_t)settings.zone);
+    LOG_INFO(SETTINGS_UPGRADED, 1);
+  }
+  else
+  {
+    settings_migrate_legacy();
+  }
+  settings_save();
+}
+
+/**
+ * Marks the RAM copy as changed, it is written after it stays quiet.
+ */
+void settings_changed(uint32_t now)
+{
+  settings_dirty = true;
+  settings_changed_at = now;
+}
+
+/**
+ * Writes the settings when dirty and quiet for SETTINGS_WRITEBACK_SECONDS,
+ * only the bytes that differ reach the EEPROM.
+ */
+void settings_writeback(uint32_t now)
+{
+  if (!settings_dirty || now - settings_changed_at < SETTINGS_WRITEBACK_SECONDS)
+  {
+    return;
+  }
+  settings_save();
+}
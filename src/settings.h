@@ -0,0 +1,44 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "storage.h"
+#include "checkpoint.h"
+#include "debug_output.h"
+#include "time_zone.h"
+#include "matrix_display.h"
+
+// layout version of the stored settings, bump it when fields change
+#define SETTINGS_VERSION 2
+// after the loose bytes of the legacy layout
+#define SETTINGS_OFFSET 16
+// quiet seconds before a change is written, mode clicks come in bursts
+#define SETTINGS_WRITEBACK_SECONDS 10
+
+#define EPOCH_BEGIN 536229000
+#define DEFAULT_TIMEZONE 0
+#define DEFAULT_BRIGHTNESS 15
+
+// version 1 kept a whole hour offset where the zone is
+struct settings_data
+{
+  uint8_t version;
+  uint8_t zone;
+  uint8_t mode_index;
+  uint8_t brightness;
+  uint32_t epoch_begin;
+  uint8_t crc;
+};
+
+static_assert(SETTINGS_OFFSET + sizeof(settings_data) <= CHECKPOINT_OFFSET, "settings overlap the checkpoint ring");
+
+extern settings_data settings;
+
+void settings_load();
+
+void settings_changed(uint32_t now);
+
+void settings_writeback(uint32_t now);
+
+#endif
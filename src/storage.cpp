@@ -1,41 +1,168 @@
 #include "storage.h"
 
+// byte writes waiting for the EEPROM, drained by the EE_READY interruption
+eeprom_write eeprom_queue[EEPROM_QUEUE_SIZE];
+// next entry the interruption writes
+volatile uint8_t eeprom_queue_head = 0;
+// next free entry
+volatile uint8_t eeprom_queue_tail = 0;
+
 /**
- * Reads GMT from eeprom
-*/
-int8_t get_timezone()
+ * Starts the next queued write of a changed byte, the interruption fires
+ * again once it is done, until the queue is empty. The EEPROM is idle here,
+ * so comparing with the stored byte doesn't wait.
+ */
+ISR(EE_READY_vect)
+{
+  while (eeprom_queue_head != eeprom_queue_tail)
+  {
+    eeprom_write entry = eeprom_queue[eeprom_queue_head % EEPROM_QUEUE_SIZE];
+    eeprom_queue_head++;
+    if (eeprom_read_byte((const uint8_t *)(uintptr_t)entry.address) == entry.value)
+    {
+      continue;
+    }
+    EEAR = entry.address;
+    EEDR = entry.value;
+    // EEPE has to follow EEMPE within 4 cycles, interruptions are off here
+    EECR |= _BV(EEMPE);
+    EECR |= _BV(EEPE);
+    return;
+  }
+  EECR &= ~_BV(EERIE);
+}
+
+/**
+ * Returns the queued write of the address or NULL, EE_READY must be masked.
+ * A queued address has one entry, later writes replace its value.
+ */
+eeprom_write *find_queued(uint16_t address)
+{
+  for (uint8_t i = eeprom_queue_head; i != eeprom_queue_tail; i++)
+  {
+    eeprom_write *entry = &eeprom_queue[i % EEPROM_QUEUE_SIZE];
+    if (entry->address == address)
+    {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Reads a byte as it will be once the queue is written.
+ * EE_READY is masked meanwhile, so the queue holds still and no write starts.
+ */
+uint8_t storage_read_byte(uint16_t address)
+{
+  uint8_t enabled = EECR & _BV(EERIE);
+  EECR &= ~_BV(EERIE);
+  uint8_t value;
+  eeprom_write *entry = find_queued(address);
+  if (entry)
+  {
+    value = entry->value;
+  }
+  else
+  {
+    // the byte may be the one being written
+    eeprom_busy_wait();
+    value = eeprom_read_byte((const uint8_t *)(uintptr_t)address);
+  }
+  if (enabled)
+  {
+    EECR |= _BV(EERIE);
+  }
+  return value;
+}
+
+void storage_read_block(void *destination, uint16_t address, uint8_t size)
+{
+  for (uint8_t i = 0; i < size; i++)
+  {
+    ((uint8_t *)destination)[i] = storage_read_byte(address + i);
+  }
+}
+
+/**
+ * Queues a byte and returns at once, EE_READY skips it if the EEPROM
+ * already holds it. An address still in the queue just takes the new value.
+ * Waits for the interruption only when the queue is full, so it must not be
+ * called with interruptions off.
+ */
+void storage_write_byte(uint16_t address, uint8_t value)
+{
+  EECR &= ~_BV(EERIE);
+  eeprom_write *entry = find_queued(address);
+  if (entry)
+  {
+    entry->value = value;
+    EECR |= _BV(EERIE);
+    return;
+  }
+  while ((uint8_t)(eeprom_queue_tail - eeprom_queue_head) >= EEPROM_QUEUE_SIZE)
+  {
+    EECR |= _BV(EERIE);
+    eeprom_busy_wait();
+    EECR &= ~_BV(EERIE);
+  }
+  entry = &eeprom_queue[eeprom_queue_tail % EEPROM_QUEUE_SIZE];
+  entry->address = address;
+  entry->value = value;
+  eeprom_queue_tail++;
+  EECR |= _BV(EERIE);
+}
+
+void storage_write_block(const void *source, uint16_t address, uint8_t size)
+{
+  for (uint8_t i = 0; i < size; i++)
+  {
+    storage_write_byte(address + i, ((const uint8_t *)source)[i]);
+  }
+}
+
+/**
+ * Waits until every queued byte is in the EEPROM.
+ * Idle sleep keeps the EEPROM running, deeper sleep modes and resets need this.
+ */
+void storage_flush()
 {
+  while (eeprom_queue_head != eeprom_queue_tail)
+  {
+    eeprom_busy_wait();
+  }
   eeprom_busy_wait();
-  return (int8_t) eeprom_read_byte(EEPROM_GMT_OFFSET);
 }
 
 /**
- * Writes GMT to eeprom
+ * Reads GMT from eeprom
 */
-void update_gmt(int8_t gmt) 
+int8_t get_timezone()
 {
-  eeprom_busy_wait();
-  eeprom_update_byte(EEPROM_GMT_OFFSET, gmt);
+  return (int8_t) storage_read_byte(EEPROM_GMT_OFFSET);
 }
 
 /**
  * Reads timestamp(4 bytes) from eeprom by index:
  * 0 - base timestamp
- * 1 - clock timestamp (just for recovering)
 */
 uint32_t get_eeprom_timestamp(byte index)
 {
-  eeprom_busy_wait();
-  return eeprom_read_dword((const uint32_t *)(EEPROM_TIMESTAMP_OFFSET + sizeof(uint32_t) * index));
+  uint32_t timestamp;
+  storage_read_block(&timestamp, EEPROM_TIMESTAMP_OFFSET + sizeof(uint32_t) * index, sizeof(timestamp));
+  return timestamp;
 }
 
 /**
- * Wtites timestamp(4 bytes) to eeprom by index:
- * 0 - base timestamp
- * 1 - clock timestamp
+ * CRC-8 (polynomial 0x07) of a block about to be stored or just read.
 */
-void update_eeprom_timestamp(byte index, uint32_t baseTimestamp)
+uint8_t storage_crc8(const void *data, uint8_t size)
 {
-  eeprom_busy_wait();
-  eeprom_update_dword((uint32_t *)(EEPROM_TIMESTAMP_OFFSET + sizeof(uint32_t) * index), baseTimestamp);
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < size; i++)
+  {
+    crc = _crc8_ccitt_update(crc, bytes[i]);
+  }
+  return crc;
 }
@@ -3,18 +3,37 @@
 
 #include <Arduino.h>
 #include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
 #include "debug_output.h"
 #include <stdint.h>
 
+// legacy layout, only read to migrate it into the settings record
 #define EEPROM_GMT_OFFSET 0
 #define EEPROM_TIMESTAMP_OFFSET 1
+// pending byte writes, a power of two
+#define EEPROM_QUEUE_SIZE 32
 
-int8_t get_timezone();
+struct eeprom_write
+{
+  uint16_t address;
+  uint8_t value;
+};
+
+uint8_t storage_read_byte(uint16_t address);
+
+void storage_read_block(void *destination, uint16_t address, uint8_t size);
+
+void storage_write_byte(uint16_t address, uint8_t value);
 
-void update_gmt(int8_t gmt);
+void storage_write_block(const void *source, uint16_t address, uint8_t size);
+
+void storage_flush();
+
+int8_t get_timezone();
 
 uint32_t get_eeprom_timestamp(byte index);
 
-void update_eeprom_timestamp(byte index, uint32_t baseTimestamp);
+uint8_t storage_crc8(const void *data, uint8_t size);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "text_format.h"
+
+/**
+ * Copies str without the terminating zero, returns the end of the text.
+ */
+char *put_str(char *p, const char *str)
+{
+  while (*str)
+  {
+    *p++ = *str++;
+  }
+  return p;
+}
+
+/**
+ * Writes decimal value zero padded to width, like "%0*lu".
+ * Returns the end of the text, the terminating zero isn't written.
+ */
+char *put_uint(char *p, uint32_t value, uint8_t width)
+{
+  char digits[UINT32_TEXT_SIZE];
+  uint8_t length = 0;
+  uint8_t digit;
+  do
+  {
+    value = radix_div10(value, &digit);
+    digits[length++] = '0' + digit;
+  } while (value);
+
+  while (width > length)
+  {
+    *p++ = '0';
+    width--;
+  }
+  while (length)
+  {
+    *p++ = digits[--length];
+  }
+  return p;
+}
+
+/**
+ * Writes signed decimal value, like "%0*ld": the sign counts in width.
+ */
+char *put_int(char *p, int32_t value, uint8_t width)
+{
+  if (value < 0)
+  {
+    *p++ = '-';
+    return put_uint(p, -(uint32_t)value, width > 0 ? width - 1 : 0);
+  }
+  return put_uint(p, value, width);
+}
+
+/**
+ * Writes year, month, day, hour and minute divided by separators[0..3].
+ * Padded text is "YYYY/MM/DD hh:mm" for "// :", otherwise "%d/%d/%d %d:%d".
+ */
+char *put_date_time(char *p, civil_time time, const char *separators, bool padded)
+{
+  p = put_uint(p, time.year, padded ? 4 : 0);
+  *p++ = separators[0];
+  p = put_uint(p, time.mon, padded ? 2 : 0);
+  *p++ = separators[1];
+  p = put_uint(p, time.day, padded ? 2 : 0);
+  *p++ = separators[2];
+  p = put_uint(p, time.hour, padded ? 2 : 0);
+  *p++ = separators[3];
+  return put_uint(p, time.min, padded ? 2 : 0);
+}
@@ -0,0 +1,70 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <UnixStamp.hpp>
+#include "radix.h"
+
+// buffer sizes with the terminating zero, for the widest values of the types
+#define UINT32_TEXT_SIZE 11
+#define INT32_TEXT_SIZE 12
+// "65535/255/255 255:255"
+#define DATE_TIME_TEXT_SIZE 22
+// "TZ " and a zone name
+#define TIMEZONE_TEXT_SIZE 15
+
+char *put_str(char *p, const char *str);
+
+char *put_uint(char *p, uint32_t value, uint8_t width);
+
+char *put_int(char *p, int32_t value, uint8_t width);
+
+char *put_date_time(char *p, civil_time time, const char *separators, bool padded);
+
+/**
+ * Decimal value, like "%lu".
+ */
+template <size_t N>
+void format_uint(char (&text)[N], uint32_t value)
+{
+  static_assert(N >= UINT32_TEXT_SIZE, "buffer is too small for uint32_t");
+  *put_uint(text, value, 0) = '\0';
+}
+
+/**
+ * Decimal value, like "%ld".
+ */
+template <size_t N>
+void format_int(char (&text)[N], int32_t value)
+{
+  static_assert(N >= INT32_TEXT_SIZE, "buffer is too small for int32_t");
+  *put_int(text, value, 0) = '\0';
+}
+
+/**
+ * Date and time up to minutes, see put_date_time().
+ */
+template <size_t N>
+void format_date_time(char (&text)[N], civil_time time, const char *separators, bool padded)
+{
+  static_assert(N >= DATE_TIME_TEXT_SIZE, "buffer is too small for date and time");
+  *put_date_time(text, time, separators, padded) = '\0';
+}
+
+/**
+ * Timezone, like "TZ %s", the name is cut to fit.
+ */
+template <size_t N>
+void format_timezone(char (&text)[N], const char *name)
+{
+  static_assert(N >= TIMEZONE_TEXT_SIZE, "buffer is too small for timezone");
+  char *p = put_str(text, "TZ ");
+  while (*name && p < text + TIMEZONE_TEXT_SIZE - 1)
+  {
+    *p++ = *name++;
+  }
+  *p = '\0';
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include "time_base.h"
+
+// SQW edges not yet applied to the counter
+volatile uint8_t pending_edges = 0;
+uint32_t unix_now = 0;
+uint16_t seconds_since_resync = 0;
+// a background burst read is on its way
+bool resync_pending = false;
+time_base_stats time_stats = {0, 0, 0, 0};
+
+#ifdef TIME_BASE_SUBSECOND
+// Timer1 counts at the last SQW edge and at the edge unix_now stands on
+volatile uint16_t edge_ticks = 0;
+uint16_t second_ticks = 0;
+volatile bool ticks_locked = false;
+#endif
+
+/**
+ * Lets the DS3231 32K output clock Timer1 through T1, free running, so
+ * sub-second time is phase locked to SQW and counts through idle sleep.
+ */
+void time_base_setup()
+{
+#ifdef TIME_BASE_SUBSECOND
+  // the 32K output is open drain
+  pinMode(TIME_BASE_32K_PIN, INPUT_PULLUP);
+  TCCR1A = 0;
+  TIMSK1 = 0;
+  TCCR1B = _BV(CS12) | _BV(CS11) | _BV(CS10);
+#endif
+}
+
+/**
+ * Called from the 1Hz SQW interruption handler, takes the 32K count of the
+ * edge. The counter is locked while edges are a second of ticks apart.
+ */
+void time_base_tick()
+{
+  pending_edges++;
+#ifdef TIME_BASE_SUBSECOND
+  uint16_t ticks = TCNT1;
+  uint16_t period = ticks - edge_ticks;
+  ticks_locked = period >= TIME_BASE_TICKS_PER_SECOND - TIME_BASE_LOCK_TOLERANCE &&
+                 period <= TIME_BASE_TICKS_PER_SECOND + TIME_BASE_LOCK_TOLERANCE;
+  if (!ticks_locked)
+  {
+    time_stats.unlocked_edges++;
+  }
+  edge_ticks = ticks;
+#endif
+}
+
+/**
+ * Takes the time of a DS3231 burst, read right after an SQW edge.
+ */
+void time_base_apply(const rtc_snapshot *snapshot)
+{
+  uint32_t rtc_now = rtc_snapshot_unixtime(snapshot);
+  cli();
+  pending_edges = 0;
+#ifdef TIME_BASE_SUBSECOND
+  second_ticks = edge_ticks;
+#endif
+  sei();
+
+  if (time_stats.resyncs > 0)
+  {
+    time_stats.last_drift = (int32_t)(rtc_now - unix_now);
+    LOG_INFO(TIME_BASE_DRIFT, time_stats.last_drift, rtc_snapshot_temperature(snapshot));
+  }
+  time_stats.resyncs++;
+  unix_now = rtc_now;
+  seconds_since_resync = 0;
+}
+
+/**
+ * Counts on from a time which didn't come from the DS3231, the next
+ * resync replaces it.
+ */
+void time_base_set(uint32_t unix_time)
+{
+  unix_now = unix_time;
+  seconds_since_resync = 0;
+}
+
+/**
+ * Reads current time from DS3231 and waits for it, at boot and after the
+ * time was set.
+ */
+void time_base_resync()
+{
+  rtc_snapshot snapshot;
+  bool read;
+  {
+    PROFILE_SCOPE(RTC_NOW);
+    read = rtc_read(&snapshot);
+  }
+  resync_pending = false;
+  if (read)
+  {
+    time_base_apply(&snapshot);
+  }
+}
+
+/**
+ * The DS3231 second restarted ticks_ago, its time was written. The next
+ * SQW edge is a second after that, sub-second time counts from there and
+ * stays locked. Call it right after the write, before time_base_resync().
+ */
+void time_base_restart(uint16_t ticks_ago)
+{
+  cli();
+  pending_edges = 0;
+#ifdef TIME_BASE_SUBSECOND
+  edge_ticks = TCNT1 - ticks_ago;
+#endif
+  sei();
+}
+
+/**
+ * Applies SQW edges counted since the last call, several edges mean the
+ * main loop was late and the counter catches up.
+ * Re-reads DS3231 every RTC_RESYNC_MINUTES in the background, the I2C
+ * access of the time base; a failed read is retried on the next second.
+ * Returns number of seconds passed.
+ */
+uint8_t time_base_update()
+{
+  if (resync_pending && rtc_twi_state() != rtc_twi_status::busy)
+  {
+    resync_pending = false;
+    rtc_snapshot snapshot;
+    if (rtc_twi_state() == rtc_twi_status::done && rtc_twi_snapshot(&snapshot))
+    {
+      time_base_apply(&snapshot);
+    }
+  }
+
+  cli();
+  uint8_t edges = pending_edges;
+  pending_edges = 0;
+#ifdef TIME_BASE_SUBSECOND
+  second_ticks = edge_ticks;
+#endif
+  sei();
+
+  if (edges == 0)
+  {
+    return 0;
+  }
+  if (edges > 1)
+  {
+    time_stats.missed_edges += edges - 1;
+  }
+  unix_now += edges;
+  seconds_since_resync += edges;
+
+  rtc_twi_tick();
+  if (seconds_since_resync >= RTC_RESYNC_MINUTES * 60 && !resync_pending)
+  {
+    resync_pending = rtc_twi_read();
+  }
+  return edges;
+}
+
+/**
+ * Current unix time, without timezone.
+ */
+uint32_t time_base_now()
+{
+  return unix_now;
+}
+
+/**
+ * 32K ticks since the second time_base_now() stands on began, 0 while the
+ * counter isn't locked to SQW. Holds at the end of the second while the
+ * edge which ends it isn't applied yet, so time doesn't run backwards.
+ */
+uint16_t time_base_ticks()
+{
+#ifdef TIME_BASE_SUBSECOND
+  cli();
+  uint16_t ticks = TCNT1 - second_ticks;
+  bool locked = ticks_locked;
+  sei();
+  if (!locked)
+  {
+    return 0;
+  }
+  return ticks < TIME_BASE_TICKS_PER_SECOND ? ticks : TIME_BASE_TICKS_PER_SECOND - 1;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Milliseconds of the current second, see time_base_ticks().
+ */
+uint16_t time_base_millis()
+{
+  return ((uint32_t)time_base_ticks() * 1000) / TIME_BASE_TICKS_PER_SECOND;
+}
+
+time_base_stats get_time_base_stats()
+{
+  return time_stats;
+}
@@ -0,0 +1,53 @@
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "rtc_clock.h"
+#include "debug_output.h"
+#include "profiler.h"
+
+// minutes between DS3231 reads in steady state
+#define RTC_RESYNC_MINUTES 10
+
+// DS3231 32K output on T1 clocks Timer1, 32768 ticks between SQW edges
+#define TIME_BASE_32K_PIN 5
+#define TIME_BASE_TICKS_PER_SECOND 32768U
+// interruption latency allowed between the counts of two SQW edges
+#define TIME_BASE_LOCK_TOLERANCE 2
+
+// PROFILE builds give Timer1 to the cycle counter, sub-second time reads 0 there
+#ifndef PROFILE
+#define TIME_BASE_SUBSECOND
+#endif
+
+struct time_base_stats
+{
+  uint32_t missed_edges;
+  uint16_t resyncs;
+  int32_t last_drift;
+  // SQW edges which came without 32768 ticks of the 32K output in between
+  uint16_t unlocked_edges;
+};
+
+void time_base_setup();
+
+void time_base_tick();
+
+uint8_t time_base_update();
+
+uint32_t time_base_now();
+
+uint16_t time_base_ticks();
+
+uint16_t time_base_millis();
+
+void time_base_set(uint32_t unix_time);
+
+void time_base_resync();
+
+void time_base_restart(uint16_t ticks_ago);
+
+time_base_stats get_time_base_stats();
+
+#endif
@@ -0,0 +1,228 @@
+#include "time_zone.h"
+
+enum dst_region
+{
+  no_dst = 0,
+  eu_dst = 1,
+  us_dst = 2,
+  au_dst = 3,
+  lord_howe_dst = 4,
+  nz_dst = 5,
+  chatham_dst = 6
+};
+
+// rules as of 2024, the table is rebuilt when a region changes them
+const dst_rule DST_RULES[] PROGMEM = {
+  {{0, 0, 0, false}, {0, 0, 0, false}, 0},
+  // 01:00 UTC on the last Sundays of March and October
+  {{3, DST_LAST_SUNDAY, 4, true}, {10, DST_LAST_SUNDAY, 4, true}, 4},
+  // 02:00 on the second Sunday of March and the first of November
+  {{3, 2, 8, false}, {11, 1, 8, false}, 4},
+  // 02:00 on the first Sunday of October, 03:00 on the first of April
+  {{10, 1, 8, false}, {4, 1, 12, false}, 4},
+  // half an hour, 02:00 on the first Sundays of October and April
+  {{10, 1, 8, false}, {4, 1, 8, false}, 2},
+  // 02:00 on the last Sunday of September, 03:00 on the first of April
+  {{9, DST_LAST_SUNDAY, 8, false}, {4, 1, 12, false}, 4},
+  // the same instants as New Zealand, 45 minutes ahead
+  {{9, DST_LAST_SUNDAY, 11, false}, {4, 1, 15, false}, 4},
+};
+
+// the whole hour zones come first, in the order of their offsets
+const zone_rule ZONE_RULES[] PROGMEM = {
+  {"UTC-11", -44, dst_region::no_dst},
+  {"UTC-10", -40, dst_region::no_dst},
+  {"UTC-09", -36, dst_region::no_dst},
+  {"UTC-08", -32, dst_region::no_dst},
+  {"UTC-07", -28, dst_region::no_dst},
+  {"UTC-06", -24, dst_region::no_dst},
+  {"UTC-05", -20, dst_region::no_dst},
+  {"UTC-04", -16, dst_region::no_dst},
+  {"UTC-03", -12, dst_region::no_dst},
+  {"UTC-02", -8, dst_region::no_dst},
+  {"UTC-01", -4, dst_region::no_dst},
+  {"UTC", 0, dst_region::no_dst},
+  {"UTC+01", 4, dst_region::no_dst},
+  {"UTC+02", 8, dst_region::no_dst},
+  {"UTC+03", 12, dst_region::no_dst},
+  {"UTC+04", 16, dst_region::no_dst},
+  {"UTC+05", 20, dst_region::no_dst},
+  {"UTC+06", 24, dst_region::no_dst},
+  {"UTC+07", 28, dst_region::no_dst},
+  {"UTC+08", 32, dst_region::no_dst},
+  {"UTC+09", 36, dst_region::no_dst},
+  {"UTC+10", 40, dst_region::no_dst},
+  {"UTC+11", 44, dst_region::no_dst},
+  {"UTC+12", 48, dst_region::no_dst},
+  {"UTC-09:30", -38, dst_region::no_dst},
+  {"UTC+03:30", 14, dst_region::no_dst},
+  {"UTC+04:30", 18, dst_region::no_dst},
+  {"UTC+05:30", 22, dst_region::no_dst},
+  {"UTC+05:45", 23, dst_region::no_dst},
+  {"UTC+06:30", 26, dst_region::no_dst},
+  {"UTC+08:45", 35, dst_region::no_dst},
+  {"UTC+09:30", 38, dst_region::no_dst},
+  {"UTC+13", 52, dst_region::no_dst},
+  {"UTC+14", 56, dst_region::no_dst},
+  {"London", 0, dst_region::eu_dst},
+  {"Berlin", 4, dst_region::eu_dst},
+  {"Helsinki", 8, dst_region::eu_dst},
+  {"St Johns", -14, dst_region::us_dst},
+  {"Halifax", -16, dst_region::us_dst},
+  {"New York", -20, dst_region::us_dst},
+  {"Chicago", -24, dst_region::us_dst},
+  {"Denver", -28, dst_region::us_dst},
+  {"Los Angeles", -32, dst_region::us_dst},
+  {"Anchorage", -36, dst_region::us_dst},
+  {"Adelaide", 38, dst_region::au_dst},
+  {"Sydney", 40, dst_region::au_dst},
+  {"Lord Howe", 42, dst_region::lord_howe_dst},
+  {"Auckland", 48, dst_region::nz_dst},
+  {"Chatham", 51, dst_region::chatham_dst},
+};
+
+const uint8_t TIME_ZONE_COUNT = sizeof(ZONE_RULES) / sizeof(ZONE_RULES[0]);
+
+static_assert(TIME_ZONE_HOURS_MAX - TIME_ZONE_HOURS_MIN < sizeof(ZONE_RULES) / sizeof(ZONE_RULES[0]),
+              "whole hour zones are missing");
+
+time_zone_state zone_state = {0, 0, 0};
+
+/**
+ * Zone of a whole hour offset, as the settings stored it before zones.
+ */
+uint8_t time_zone_from_hours(int8_t hours)
+{
+  if (hours < TIME_ZONE_HOURS_MIN || hours > TIME_ZONE_HOURS_MAX)
+  {
+    hours = 0;
+  }
+  return hours - TIME_ZONE_HOURS_MIN;
+}
+
+void read_zone_rule(zone_rule *rule, uint8_t zone)
+{
+  if (zone >= TIME_ZONE_COUNT)
+  {
+    zone = time_zone_from_hours(0);
+  }
+  memcpy_P(rule, &ZONE_RULES[zone], sizeof(zone_rule));
+}
+
+void time_zone_name(char (&name)[TIME_ZONE_NAME_SIZE], uint8_t zone)
+{
+  zone_rule rule;
+  read_zone_rule(&rule, zone);
+  memcpy(name, rule.name, TIME_ZONE_NAME_SIZE);
+}
+
+/**
+ * Unix time of the change in the year, offset is the one before it.
+ */
+uint32_t dst_change_time(const dst_change *change, uint16_t year, int8_t offset)
+{
+  uint32_t days;
+  if (change->sunday == DST_LAST_SUNDAY)
+  {
+    days = calendar_days(year, change->month, get_days_in_month(change->month, year));
+    days -= calendar_weekday(days);
+  }
+  else
+  {
+    days = calendar_days(year, change->month, 1);
+    days += (7 - calendar_weekday(days)) % 7 + 7 * (change->sunday - 1);
+  }
+  uint32_t time = days * 86400UL + change->quarter * TIME_ZONE_QUARTER;
+  return change->utc ? time : time - offset * TIME_ZONE_QUARTER;
+}
+
+/**
+ * Evaluates the rules around the time: the offset in quarter hours and
+ * the next change after it.
+ */
+int8_t evaluate_zone(uint8_t zone, uint32_t unix_time, uint32_t *next_transition)
+{
+  zone_rule rule;
+  read_zone_rule(&rule, zone);
+  *next_transition = TIME_ZONE_NO_TRANSITION;
+  if (rule.dst == dst_region::no_dst)
+  {
+    return rule.offset;
+  }
+  dst_rule dst;
+  memcpy_P(&dst, &DST_RULES[rule.dst], sizeof(dst_rule));
+
+  // the last change before the time is in this year or the year before
+  uint16_t year = UnixStamp::convertUnixToTime(unix_time, 0).year;
+  uint32_t last_transition = 0;
+  bool daylight = false;
+  for (uint16_t y = year > 1970 ? year - 1 : year; y <= year + 1; y++)
+  {
+    uint32_t changes[2] = {dst_change_time(&dst.start, y, rule.offset),
+                           dst_change_time(&dst.end, y, rule.offset + dst.save)};
+    for (uint8_t i = 0; i < 2; i++)
+    {
+      if (changes[i] <= unix_time && changes[i] >= last_transition)
+      {
+        last_transition = changes[i];
+        daylight = i == 0;
+      }
+      else if (changes[i] > unix_time && changes[i] < *next_transition)
+      {
+        *next_transition = changes[i];
+      }
+    }
+  }
+  return daylight ? rule.offset + dst.save : rule.offset;
+}
+
+/**
+ * Seconds to add to the unix time for the local time of the zone.
+ */
+int32_t time_zone_offset_at(uint8_t zone, uint32_t unix_time)
+{
+  uint32_t next_transition;
+  return evaluate_zone(zone, unix_time, &next_transition) * TIME_ZONE_QUARTER;
+}
+
+/**
+ * Unix time of an entered local time. In the hour skipped by a change
+ * it lands an hour off, a repeated hour resolves to its second pass.
+ */
+uint32_t time_zone_to_utc(uint8_t zone, uint32_t local_time)
+{
+  zone_rule rule;
+  read_zone_rule(&rule, zone);
+  uint32_t standard = local_time - rule.offset * TIME_ZONE_QUARTER;
+  return local_time - time_zone_offset_at(zone, standard);
+}
+
+/**
+ * Makes the zone current, rules are evaluated now and at its changes only.
+ */
+void time_zone_select(uint8_t zone, uint32_t now)
+{
+  zone_state.zone = zone;
+  zone_state.offset = evaluate_zone(zone, now, &zone_state.next_transition);
+  LOG_INFO(TIME_ZONE_OFFSET, zone, zone_state.offset * 15, zone_state.next_transition);
+}
+
+/**
+ * Called every second, mostly it is the single compare.
+ */
+void time_zone_update(uint32_t now)
+{
+  if (now < zone_state.next_transition)
+  {
+    return;
+  }
+  time_zone_select(zone_state.zone, now);
+}
+
+/**
+ * Local time of the current zone, from the cached offset.
+ */
+uint32_t time_zone_local(uint32_t now)
+{
+  return now + zone_state.offset * TIME_ZONE_QUARTER;
+}
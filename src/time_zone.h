@@ -0,0 +1,73 @@
+#ifndef TIME_ZONE_H
+#define TIME_ZONE_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include <UnixStamp.hpp>
+#include "calendar.h"
+#include "debug_output.h"
+
+// offsets are kept in quarter hours, the finest step zones use
+#define TIME_ZONE_QUARTER 900L
+// "Los Angeles" and the terminating zero
+#define TIME_ZONE_NAME_SIZE 12
+// the first zones are the whole hour offsets the settings used to store
+#define TIME_ZONE_HOURS_MIN -11
+#define TIME_ZONE_HOURS_MAX 12
+#define TIME_ZONE_NO_TRANSITION 0xFFFFFFFF
+
+// transition on the last Sunday of the month
+#define DST_LAST_SUNDAY 5
+
+/**
+ * A DST change on the n-th Sunday of the month.
+ * The time of day is the local time before the change, or UTC.
+ */
+struct dst_change
+{
+  uint8_t month;
+  uint8_t sunday;
+  uint8_t quarter;
+  bool utc;
+};
+
+struct dst_rule
+{
+  dst_change start;
+  dst_change end;
+  int8_t save;
+};
+
+struct zone_rule
+{
+  char name[TIME_ZONE_NAME_SIZE];
+  int8_t offset;
+  uint8_t dst;
+};
+
+// the offset in effect, valid until next_transition
+struct time_zone_state
+{
+  uint8_t zone;
+  int8_t offset;
+  uint32_t next_transition;
+};
+
+extern const uint8_t TIME_ZONE_COUNT;
+
+uint8_t time_zone_from_hours(int8_t hours);
+
+void time_zone_name(char (&name)[TIME_ZONE_NAME_SIZE], uint8_t zone);
+
+int32_t time_zone_offset_at(uint8_t zone, uint32_t unix_time);
+
+uint32_t time_zone_to_utc(uint8_t zone, uint32_t local_time);
+
+void time_zone_select(uint8_t zone, uint32_t now);
+
+void time_zone_update(uint32_t now);
+
+uint32_t time_zone_local(uint32_t now);
+
+#endif
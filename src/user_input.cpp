@@ -12,142 +12,176 @@ enum input_field
 
 /**
  * Checks user input, min and max are range boundaries, included.
- * If user input is not in the range, min or max is returned.
+ * Input below min wraps to max and input above max wraps to min.
  */
 int16_t check_user_input(int16_t min, int16_t max, int16_t input)
 {
-  return (input < min) ? max - input : ((input > max) ? (min + input - max) : input);
+  return (input < min) ? max : ((input > max) ? min : input);
 }
 
 /**
- * Check leap year
+ * Range of the field, min and max are included.
  */
-bool is_leap_year(int year)
+void get_field_range(time_input *input, int16_t *min, int16_t *max)
 {
-  return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+  switch (input->field)
+  {
+  case input_field::tz:
+    *min = 0;
+    *max = TIME_ZONE_COUNT - 1;
+    break;
+  case input_field::year:
+    *min = 1970;
+    *max = 2099;
+    break;
+  case input_field::mon:
+    *min = 1;
+    *max = 12;
+    break;
+  case input_field::day:
+    *min = 1;
+    *max = get_days_in_month(input->time.mon, input->time.year);
+    break;
+  case input_field::hour:
+    *min = 0;
+    *max = 23;
+    break;
+  default:
+    *min = 0;
+    *max = 59;
+    break;
+  }
 }
 
-/**
- * Get max days in monty
- */
-uint8_t get_days_in_month(uint8_t month, uint16_t year)
+int16_t get_field_value(time_input *input)
 {
-  const uint8_t days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-
-  if (month == 2 && is_leap_year(year))
+  switch (input->field)
   {
-    return days_in_month[month - 1] + 1;
+  case input_field::tz:
+    return input->zone;
+  case input_field::year:
+    return input->time.year;
+  case input_field::mon:
+    return input->time.mon;
+  case input_field::day:
+    return input->time.day;
+  case input_field::hour:
+    return input->time.hour;
+  default:
+    return input->time.min;
   }
-
-  return days_in_month[month - 1];
 }
 
-char* get_msg_template(civil_time time, input_field field) 
+void set_field_value(time_input *input, int16_t value)
 {
-  const char *templates[] = {
-    "TZ UTC(%02d)", 
-    "%s/%02u/%02u %02u:%02u", 
-    "%04u/%s/%02u %02u:%02u", 
-    "%04u/%02u/%s %02u:%02u", 
-    "%04u/%02u/%02u %s:%02u", 
-    "%04u/%02u/%02u %02u:%s"
-    };
-  char *msg_template = (char *)calloc(32, sizeof(char));
-  switch (field)
-  {
-  case input_field::tz: 
+  switch (input->field)
   {
-    return const_cast<char*>(templates[field]);
-  }
+  case input_field::tz:
+    input->zone = (uint8_t)value;
     break;
-  case input_field::year: 
-  {
-    sprintf(msg_template, templates[field], "%04u", time.mon, time.day, time.hour, time.min);
-  }
+  case input_field::year:
+    input->time.year = (uint16_t)value;
     break;
   case input_field::mon:
-  {
-    sprintf(msg_template, templates[field], time.year, "%02u", time.day, time.hour, time.min);
-  }
+    input->time.mon = (uint8_t)value;
     break;
   case input_field::day:
-  {
-    sprintf(msg_template, templates[field], time.year, time.mon, "%02u", time.hour, time.min);
-  }
+    input->time.day = (uint8_t)value;
     break;
   case input_field::hour:
-  {
-    sprintf(msg_template, templates[field], time.year, time.mon, time.day, "%02u", time.min);
-  }
-    break;
-  case input_field::min:
-  {
-    sprintf(msg_template, templates[field], time.year, time.mon, time.day, time.hour, "%02u");
-  }
+    input->time.hour = (uint8_t)value;
     break;
   default:
-    msg_template = NULL;
+    input->time.min = (uint8_t)value;
     break;
   }
-  return msg_template;
 }
 
 /**
- * Enter a value.
+ * Moves the cursor to the field and shows its current value.
  */
-int16_t user_input(civil_time time, input_field field, int16_t min, int16_t max, int16_t current, RTC_DS3231 *rtc, Button *position_button, Button *plus_button, Button *minus_button)
+void select_field(time_input *input, uint8_t field)
 {
-  uint32_t menu_seconds = rtc->now().secondstime();
-  char *msg, *msg_template;
-  msg_template = get_msg_template(time, field);
-  msg = (char *)calloc(18, sizeof(char));
-  sprintf(msg, msg_template, 0);
-  do
-  {
-    plus_button->clear();
-    minus_button->clear();
-    plus_button->tick();
-    minus_button->tick();
-    position_button->clear();
-    position_button->tick();
+  input->field = field;
+  input->value = get_field_value(input);
+  input->last_action = time_base_now();
+  input->redraw = true;
+}
 
+/**
+ * Shows the timezone name alone or the date with the edited field.
+ */
+void display_user_input(time_input *input)
+{
+  PROFILE_SCOPE(USER_INPUT_REDRAW);
+  if (input->field == input_field::tz)
+  {
+    char name[TIME_ZONE_NAME_SIZE];
+    time_zone_name(name, input->value);
+    char msg[TIMEZONE_TEXT_SIZE];
+    format_timezone(msg, name);
     matrix_display_string(msg);
+    return;
+  }
+  time_input shown = *input;
+  set_field_value(&shown, input->value);
+  char msg[DATE_TIME_TEXT_SIZE];
+  format_date_time(msg, shown.time, "// :", true);
+  matrix_display_string(msg);
+}
 
-    if (plus_button->hasClicks() || minus_button->hasClicks())
-    {
-      current += plus_button->getClicks() - minus_button->getClicks();
-      current = check_user_input(min, max, current);
-      menu_seconds = rtc->now().secondstime();
-      free(msg);
-      msg = (char *)calloc(18, sizeof(char));
-      sprintf(msg, msg_template, current);
-    }
+/**
+ * Starts time input, fields are edited one by one from timezone to minutes.
+ */
+void user_input_time_begin(time_input *input, civil_time time, uint8_t zone)
+{
+  input->time = time;
+  input->zone = zone;
+  select_field(input, input_field::tz);
+}
+
+/**
+ * Handles buttons for the current field and redraws it if something changed.
+ * A position click or MENU_THRESSHOLD seconds without clicks accepts the value
+ * and moves to the next field.
+ * Returns true when all fields are entered.
+ */
+bool user_input_time_step(time_input *input, button *next_position_button, button *plus_button, button *minus_button)
+{
+  if (button_has_clicks(plus_button) || button_has_clicks(minus_button))
+  {
+    int16_t min, max;
+    get_field_range(input, &min, &max);
+    input->value += button_clicks(plus_button) - button_clicks(minus_button);
+    input->value = check_user_input(min, max, input->value);
+    input->last_action = time_base_now();
+    input->redraw = true;
+  }
 
-    if (position_button->hasClicks())
+  if (button_has_clicks(next_position_button) || (time_base_now() - input->last_action) >= MENU_THRESSHOLD)
+  {
+    set_field_value(input, input->value);
+    if (input->field == input_field::min)
     {
-      return current;
+      return true;
     }
+    select_field(input, input->field + 1);
+  }
 
-  } while ((rtc->now().secondstime() - menu_seconds) < MENU_THRESSHOLD);
-
-  free(msg);
-  free(msg_template);
-  return current;
+  if (input->redraw)
+  {
+    input->redraw = false;
+    display_user_input(input);
+  }
+  return false;
 }
 
 /**
- * Get and converts user input into unixtime object.
+ * Converts entered local fields into unix time, with the offset of the
+ * zone at that time.
  */
-UnixStamp user_input_time(civil_time time, int8_t time_zone, RTC_DS3231 *rtc, Button *next_position_button, Button *plus_button, Button *minus_button)
+uint32_t user_input_time_result(time_input *input)
 {
-  time_zone = (int8_t)user_input(time, input_field::tz, -11, 12, (int16_t)time_zone, rtc, next_position_button, plus_button, minus_button);
-  time.year = (uint16_t)user_input(time, input_field::year, 1970, 2099, (int16_t)time.year, rtc, next_position_button, plus_button, minus_button);
-  time.mon = (uint8_t)user_input(time, input_field::mon, 1, 12, (int16_t)time.mon, rtc, next_position_button, plus_button, minus_button);
-  uint8_t max_day = get_days_in_month(time.mon, time.year);
-  time.day = (uint8_t)user_input(time, input_field::day, 1, max_day, (int16_t)time.day, rtc, next_position_button, plus_button, minus_button);
-  time.hour = (uint8_t)user_input(time, input_field::hour, 0, 23, (int16_t)time.hour, rtc, next_position_button, plus_button, minus_button);
-  time.min = (uint8_t)user_input(time, input_field::min, 0, 59, (int16_t)time.min, rtc, next_position_button, plus_button, minus_button);
-
-  UnixStamp unix_stamp(time, time_zone);
-  return unix_stamp;
-}
\ No newline at end of file
+  UnixStamp local_stamp(input->time, 0);
+  return time_zone_to_utc(input->zone, local_stamp.getUnix());
+}
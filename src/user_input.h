@@ -2,15 +2,34 @@
 #define USER_INPUT_H
 
 #include <UnixStamp.hpp>
-#include <EncButton.h>
 #include "debug_output.h"
 #include "stdint.h"
 #include "matrix_display.h"
 #include "rtc_clock.h"
+#include "time_base.h"
 #include "memory.h"
+#include "text_format.h"
+#include "profiler.h"
+#include "buttons.h"
+#include "calendar.h"
+#include "time_zone.h"
 
 const uint8_t MENU_THRESSHOLD = 5;
 
-UnixStamp user_input_time(civil_time time, int8_t time_zone, RTC_DS3231 *rtc, Button *next_position_button, Button *plus_button, Button *minus_button);
+struct time_input
+{
+  civil_time time;
+  uint8_t zone;
+  uint8_t field;
+  int16_t value;
+  uint32_t last_action;
+  bool redraw;
+};
+
+void user_input_time_begin(time_input *input, civil_time time, uint8_t zone);
+
+bool user_input_time_step(time_input *input, button *next_position_button, button *plus_button, button *minus_button);
+
+uint32_t user_input_time_result(time_input *input);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+/**
+ * Button edges through the pin change interruption of the simulator,
+ * including a burst which overflows the edge ring.
+ */
+#include <unity.h>
+#include "buttons.h"
+#include "hardware.h"
+
+button test_button;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void drive(bool level)
+{
+  uint64_t now = sim_now_us() + 1000;
+  sim_drive_pin(now, BUTTON_CHANGE_MODE_PIN, level);
+  sim_advance_to(now);
+}
+
+/**
+ * Lets the loop see the edges, a level it read from the pins is dated by
+ * this tick and debounces on the next one.
+ */
+void settle()
+{
+  buttons_tick();
+  sim_advance_to(sim_now_us() + (BUTTON_DEBOUNCE_MS + 10) * 1000UL);
+  buttons_tick();
+}
+
+void test_edge_after_drop_is_captured()
+{
+  button_attach(&test_button, BUTTON_CHANGE_MODE_PIN);
+  uint16_t dropped = get_button_stats().dropped_edges;
+
+  // an odd number of edges fills the ring with the button down, the last
+  // one releasing it doesn't fit
+  for (uint8_t i = 0; i < BUTTON_RING_SIZE; i++)
+  {
+    drive(i & 1);
+  }
+  TEST_ASSERT_EQUAL_UINT16(dropped + 1, get_button_stats().dropped_edges);
+  settle();
+  TEST_ASSERT_FALSE(test_button.pressed);
+
+  // the next press has the levels of the last edge in the ring
+  drive(LOW);
+  settle();
+  TEST_ASSERT_TRUE(test_button.pressed);
+
+  drive(HIGH);
+  settle();
+  TEST_ASSERT_FALSE(test_button.pressed);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_edge_after_drop_is_captured);
+  return UNITY_END();
+}
@@ -0,0 +1,98 @@
+/**
+ * Calendar stepped a second at a time against the full conversion of
+ * UnixStamp, for every second from 1970 to the end of 2099.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include "calendar.h"
+
+// 2000-01-01 and 2100-01-01 00:00:00 UTC
+#define UNIX_2000 946684800UL
+#define UNIX_2100 4102444800UL
+#define YEAR_SECONDS (366 * 86400UL)
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Steps the calendar over [from, to) and compares every second, returns
+ * at the first mismatch.
+ */
+void check_seconds(uint32_t from, uint32_t to, int8_t time_zone)
+{
+  calendar cal;
+  calendar_set(&cal, from, time_zone);
+  for (uint32_t unix_time = from; unix_time != to; unix_time++)
+  {
+    calendar_advance(&cal, unix_time);
+    civil_time expected = UnixStamp::convertUnixToTime(unix_time, time_zone);
+    if (cal.time.year != expected.year || cal.time.mon != expected.mon || cal.time.day != expected.day ||
+        cal.time.hour != expected.hour || cal.time.min != expected.min || cal.second != unix_time % 60)
+    {
+      char message[96];
+      snprintf(message, sizeof(message), "at %lu UTC%+d: %04u/%02u/%02u %02u:%02u:%02u, expected %04u/%02u/%02u %02u:%02u",
+               (unsigned long)unix_time, time_zone, cal.time.year, cal.time.mon, cal.time.day, cal.time.hour,
+               cal.time.min, cal.second, expected.year, expected.mon, expected.day, expected.hour, expected.min);
+      TEST_FAIL_MESSAGE(message);
+    }
+  }
+}
+
+void test_every_second_utc()
+{
+  check_seconds(0, UNIX_2100, 0);
+}
+
+/**
+ * The zones only shift where the carries happen, a year around each
+ * century boundary covers the leap day of 2000 and the year ends.
+ */
+void test_every_second_in_zones()
+{
+  const int8_t ZONES[] = {12, -11, 1};
+  for (int8_t time_zone : ZONES)
+  {
+    check_seconds(UNIX_2000 - YEAR_SECONDS, UNIX_2000 + YEAR_SECONDS, time_zone);
+    check_seconds(UNIX_2100 - YEAR_SECONDS, UNIX_2100 - 12 * 3600UL, time_zone);
+  }
+}
+
+/**
+ * Jumps and steps back are converted from scratch.
+ */
+void test_jumps()
+{
+  calendar cal;
+  calendar_set(&cal, UNIX_2000, 3);
+  uint32_t unix_time = UNIX_2000;
+  const uint32_t STEPS[] = {CALENDAR_STEP_MAX, CALENDAR_STEP_MAX + 1, 86400, (uint32_t)-1, (uint32_t)-86400, 1};
+  for (uint8_t round = 0; round < 100; round++)
+  {
+    for (uint32_t step : STEPS)
+    {
+      unix_time += step * (round + 1);
+      calendar_advance(&cal, unix_time);
+      civil_time expected = UnixStamp::convertUnixToTime(unix_time, 3);
+      TEST_ASSERT_EQUAL_UINT16(expected.year, cal.time.year);
+      TEST_ASSERT_EQUAL_UINT8(expected.mon, cal.time.mon);
+      TEST_ASSERT_EQUAL_UINT8(expected.day, cal.time.day);
+      TEST_ASSERT_EQUAL_UINT8(expected.hour, cal.time.hour);
+      TEST_ASSERT_EQUAL_UINT8(expected.min, cal.time.min);
+      TEST_ASSERT_EQUAL_UINT8(unix_time % 60, cal.second);
+    }
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_every_second_utc);
+  RUN_TEST(test_every_second_in_zones);
+  RUN_TEST(test_jumps);
+  return UNITY_END();
+}
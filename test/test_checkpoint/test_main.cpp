@@ -0,0 +1,144 @@
+/**
+ * Search for the newest checkpoint on the simulated EEPROM, across laps of
+ * the ring and with erased, zeroed and torn slots.
+ */
+#include <unity.h>
+#include "checkpoint.h"
+#include "hardware.h"
+
+#define FIRST_TIME 1700000000UL
+#define STEP (CHECKPOINT_MINUTES * 60UL)
+
+void fill_ring(uint8_t value)
+{
+  storage_flush();
+  uint8_t bytes[CHECKPOINT_SLOTS * sizeof(checkpoint_record)];
+  memset(bytes, value, sizeof(bytes));
+  eeprom_update_block(bytes, (void *)CHECKPOINT_OFFSET, sizeof(bytes));
+}
+
+void fill_slot(uint8_t slot, uint8_t value, uint8_t size)
+{
+  uint8_t bytes[sizeof(checkpoint_record)];
+  memset(bytes, value, size);
+  eeprom_update_block(bytes, (void *)(CHECKPOINT_OFFSET + slot * sizeof(checkpoint_record)), size);
+}
+
+/**
+ * Writes count checkpoints into an erased ring, the i-th at FIRST_TIME + i * STEP.
+ */
+void write_checkpoints(uint16_t count)
+{
+  fill_ring(0xFF);
+  checkpoint_setup();
+  for (uint16_t i = 0; i < count; i++)
+  {
+    checkpoint_write(FIRST_TIME + i * STEP);
+  }
+  storage_flush();
+}
+
+void assert_newest(uint16_t index)
+{
+  checkpoint_setup();
+  uint32_t unix_time;
+  TEST_ASSERT_TRUE(checkpoint_newest(&unix_time));
+  TEST_ASSERT_EQUAL_UINT32(FIRST_TIME + index * STEP, unix_time);
+}
+
+void assert_empty()
+{
+  checkpoint_setup();
+  uint32_t unix_time;
+  TEST_ASSERT_FALSE(checkpoint_newest(&unix_time));
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_erased_ring_is_empty()
+{
+  fill_ring(0xFF);
+  assert_empty();
+}
+
+void test_zeroed_ring_is_empty()
+{
+  fill_ring(0x00);
+  assert_empty();
+}
+
+void test_finds_newest_around_the_ring()
+{
+  const uint16_t COUNTS[] = {1, 2, 3, CHECKPOINT_SLOTS / 2, CHECKPOINT_SLOTS - 1, CHECKPOINT_SLOTS,
+                             CHECKPOINT_SLOTS + 1, CHECKPOINT_SLOTS + 80, 2 * CHECKPOINT_SLOTS, 2 * CHECKPOINT_SLOTS + 1};
+  for (uint16_t count : COUNTS)
+  {
+    write_checkpoints(count);
+    assert_newest(count - 1);
+  }
+}
+
+/**
+ * Slots after the newest one cleared whole or in part.
+ */
+void test_cleared_slots_after_newest()
+{
+  write_checkpoints(50);
+  for (uint8_t slot = 50; slot < CHECKPOINT_SLOTS; slot++)
+  {
+    fill_slot(slot, 0x00, sizeof(checkpoint_record));
+  }
+  assert_newest(49);
+
+  write_checkpoints(50);
+  fill_slot(50, 0x00, sizeof(checkpoint_record) / 2);
+  assert_newest(49);
+}
+
+/**
+ * Zeroed slots of the previous lap, the anchor slot 0 among them.
+ */
+void test_zeroed_slots_of_previous_lap()
+{
+  write_checkpoints(CHECKPOINT_SLOTS + 80);
+  fill_slot(100, 0x00, sizeof(checkpoint_record));
+  assert_newest(CHECKPOINT_SLOTS + 79);
+
+  write_checkpoints(CHECKPOINT_SLOTS + 80);
+  fill_slot(0, 0x00, sizeof(checkpoint_record));
+  assert_newest(CHECKPOINT_SLOTS + 79);
+}
+
+/**
+ * Power lost in the middle of the newest write: its first bytes are new,
+ * the others still hold the previous lap or the erased cells.
+ */
+void test_torn_newest_write()
+{
+  write_checkpoints(50);
+  fill_slot(49, 0xFF, 3);
+  assert_newest(48);
+
+  // the newest in slot 0, the previous lap starts at slot 1
+  write_checkpoints(CHECKPOINT_SLOTS + 1);
+  fill_slot(0, 0x00, 2);
+  assert_newest(CHECKPOINT_SLOTS - 1);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_erased_ring_is_empty);
+  RUN_TEST(test_zeroed_ring_is_empty);
+  RUN_TEST(test_finds_newest_around_the_ring);
+  RUN_TEST(test_cleared_slots_after_newest);
+  RUN_TEST(test_zeroed_slots_of_previous_lap);
+  RUN_TEST(test_torn_newest_write);
+  return UNITY_END();
+}
@@ -0,0 +1,187 @@
+/**
+ * Digit renderer against the GFX print() path it replaced: the same pixels
+ * for counting, jumping and shrinking values, and the columns redrawn per tick.
+ */
+#include <unity.h>
+#include "matrix_display.h"
+#include "digit_renderer.h"
+
+#define TICKS 5000
+
+extern MAX7219<DISPLAY_MODULES, 1, DISPLAY_CS_PIN> mtrx;
+
+struct digits_layout
+{
+  uint8_t base;
+  uint8_t x;
+};
+
+// the oct, dec and hex modes
+const digits_layout LAYOUTS[] = {{8, 16}, {10, 16}, {16, 27}};
+
+uint8_t drawn[sizeof(mtrx.buffer)];
+
+void setUp()
+{
+  display_setup(0);
+  digit_renderer_setup();
+  memset(drawn, 0, sizeof(drawn));
+}
+
+void tearDown()
+{
+}
+
+/**
+ * The former display_time() branch of the digit modes.
+ */
+void print_digits(uint32_t value, uint8_t base, uint8_t x)
+{
+  mtrx.clear();
+  mtrx.setCursor(x, 0);
+  mtrx.print(value, base);
+}
+
+/**
+ * Draws value both ways, the renderer over its own previous frame.
+ */
+void check_value(uint32_t value, const digits_layout &layout)
+{
+  uint8_t expected[sizeof(mtrx.buffer)];
+  print_digits(value, layout.base, layout.x);
+  memcpy(expected, mtrx.buffer, sizeof(expected));
+
+  memcpy(mtrx.buffer, drawn, sizeof(drawn));
+  draw_digits(value, layout.base, 0, layout.x, false);
+  memcpy(drawn, mtrx.buffer, sizeof(drawn));
+
+  char message[48];
+  snprintf(message, sizeof(message), "%lu in base %u", (unsigned long)value, layout.base);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, drawn, sizeof(expected), message);
+}
+
+void test_counting_matches_print()
+{
+  const uint32_t STARTS[] = {0, 1700000000, 0xFFFFFFFF - 5000};
+  for (const digits_layout &layout : LAYOUTS)
+  {
+    for (uint32_t start : STARTS)
+    {
+      digit_renderer_reset();
+      memset(drawn, 0, sizeof(drawn));
+      for (uint32_t value = start; value - start <= 5000 && value >= start; value++)
+      {
+        check_value(value, layout);
+      }
+    }
+  }
+}
+
+void test_jumps_match_print()
+{
+  for (const digits_layout &layout : LAYOUTS)
+  {
+    digit_renderer_reset();
+    memset(drawn, 0, sizeof(drawn));
+    uint32_t value = 12345;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+      // lengths go up and down, shorter values must not leave glyphs behind
+      value = value * 1664525 + 1013904223;
+      check_value(value >> (value & 31), layout);
+    }
+  }
+}
+
+/**
+ * The hex_millis fields: zero padded to their width, the fixed one cut to its
+ * low digits, against print() of the padded text.
+ */
+void test_padding_matches_print()
+{
+  const uint32_t VALUES[] = {0, 0x1F, 0xABC, 0x12345, 0x6553F1A0, 0xFFFFFFFF};
+  for (uint32_t value : VALUES)
+  {
+    char text[12];
+    snprintf(text, sizeof(text), "%08lX", (unsigned long)value);
+    mtrx.clear();
+    mtrx.setCursor(14, 0);
+    mtrx.print(text);
+    uint8_t expected[sizeof(mtrx.buffer)];
+    memcpy(expected, mtrx.buffer, sizeof(expected));
+
+    mtrx.clear();
+    digit_renderer_reset();
+    draw_digits(value, 16, 8, 14, false);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, mtrx.buffer, sizeof(expected), text);
+
+    snprintf(text, sizeof(text), "%03lX", (unsigned long)(value & 0xFFF));
+    mtrx.clear();
+    mtrx.setCursor(64, 0);
+    mtrx.print(text);
+    memcpy(expected, mtrx.buffer, sizeof(expected));
+
+    mtrx.clear();
+    draw_fixed_digits(value, 16, 3, 64);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, mtrx.buffer, sizeof(expected), text);
+  }
+}
+
+/**
+ * Digits of value in base as print() writes them.
+ */
+void format_digits(char *text, uint32_t value, uint8_t base)
+{
+  const char *FORMATS[] = {"%lo", "%lu", "%lX"};
+  snprintf(text, 12, FORMATS[base == 8 ? 0 : base == 10 ? 1 : 2], (unsigned long)value);
+}
+
+/**
+ * Columns written per one-second tick: the glyphs leave the bottom row
+ * blank, so a mark set there survives in every column which wasn't redrawn.
+ */
+void test_tick_redraws_changed_digits()
+{
+  for (const digits_layout &layout : LAYOUTS)
+  {
+    mtrx.clear();
+    digit_renderer_reset();
+    draw_digits(1700000000, layout.base, 0, layout.x, false);
+    for (uint32_t value = 1700000001; value <= 1700000000 + TICKS; value++)
+    {
+      for (uint8_t x = 0; x < DISPLAY_MODULES * 8; x++)
+      {
+        display_write_column(x, display_read_column(x) | 0x80);
+      }
+      draw_digits(value, layout.base, 0, layout.x, false);
+
+      uint8_t written = 0;
+      for (uint8_t x = 0; x < DISPLAY_MODULES * 8; x++)
+      {
+        written += !(display_read_column(x) & 0x80);
+      }
+      char previous[12];
+      char current[12];
+      format_digits(previous, value - 1, layout.base);
+      format_digits(current, value, layout.base);
+      uint8_t changed = 0;
+      for (uint8_t i = 0; current[i]; i++)
+      {
+        changed += current[i] != previous[i];
+      }
+      char message[48];
+      snprintf(message, sizeof(message), "%s in base %u", current, layout.base);
+      TEST_ASSERT_EQUAL_UINT8_MESSAGE(changed * GLYPH_ADVANCE, written, message);
+    }
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_counting_matches_print);
+  RUN_TEST(test_jumps_match_print);
+  RUN_TEST(test_padding_matches_print);
+  RUN_TEST(test_tick_redraws_changed_digits);
+  return UNITY_END();
+}
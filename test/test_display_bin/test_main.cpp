@@ -0,0 +1,172 @@
+/**
+ * Binary mode from the nibble column table against the former drawing with
+ * a bool array and per-pixel lineV()/rectWH(), and the rows the dirty update
+ * sends through the simulated SPI.
+ */
+#include <unity.h>
+#include "matrix_display.h"
+#include "digit_renderer.h"
+#include "hardware.h"
+
+extern MAX7219<DISPLAY_MODULES, 1, DISPLAY_CS_PIN> mtrx;
+
+void setUp()
+{
+  display_setup(0);
+}
+
+void tearDown()
+{
+}
+
+/**
+ * The former display_bin(), cells of 3x3 wrapping at DISPLAY_WIDTH + START_POSITION.
+ */
+void draw_bin_pixels(uint32_t time)
+{
+  const uint8_t HEIGHT = 3;
+  const uint8_t WiDITH = 3;
+  const uint8_t DISPLAY_WIDTH = 63;
+  const uint8_t START_POSITION = 16;
+  bool bin_time[32];
+  uint8_t x = START_POSITION;
+  uint8_t y = 0;
+
+  for (uint8_t i = 0; i < sizeof(uint32_t) * 8; i++)
+  {
+    uint8_t num = (time >> i) & 1;
+    bin_time[sizeof(uint32_t) * 8 - 1 - i] = num == 1;
+  }
+
+  for (uint8_t i = 0; i < sizeof(uint32_t) * 8; i++)
+  {
+    if (bin_time[i])
+    {
+      mtrx.lineV(x, y, y + HEIGHT - 1);
+    }
+    else
+    {
+      mtrx.rectWH(x, y, WiDITH, HEIGHT, GFX_STROKE);
+    }
+    x = x + WiDITH + 1;
+    if (x >= DISPLAY_WIDTH + START_POSITION)
+    {
+      x = START_POSITION;
+      y = HEIGHT + 1;
+    }
+  }
+}
+
+void check_time(uint32_t time)
+{
+  uint8_t expected[sizeof(mtrx.buffer)];
+  mtrx.clear();
+  draw_bin_pixels(time);
+  memcpy(expected, mtrx.buffer, sizeof(expected));
+
+  // the table writes whole columns, so any previous content is overwritten
+  mtrx.fill(0xA5);
+  for (uint8_t x = 0; x < DISPLAY_MODULES * 8; x++)
+  {
+    if (x < 16 || x >= 16 + 64)
+    {
+      display_write_column(x, 0);
+    }
+  }
+  display_bin(time);
+
+  char message[32];
+  snprintf(message, sizeof(message), "time 0x%08lX", (unsigned long)time);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, mtrx.buffer, sizeof(expected), message);
+}
+
+void test_every_nibble_in_every_position()
+{
+  for (uint8_t shift = 0; shift < 32; shift += 4)
+  {
+    for (uint32_t nibble = 0; nibble < 16; nibble++)
+    {
+      check_time(nibble << shift);
+      check_time(~(nibble << shift));
+    }
+  }
+}
+
+void test_many_timestamps()
+{
+  uint32_t time = 1;
+  for (uint32_t i = 0; i < 200000; i++)
+  {
+    time ^= time << 13;
+    time ^= time >> 17;
+    time ^= time << 5;
+    check_time(time);
+  }
+  for (uint32_t time = 1700000000; time < 1700100000; time++)
+  {
+    check_time(time);
+  }
+}
+
+/**
+ * Rows of the frame buffer which differ from the previous frame.
+ */
+uint8_t changed_rows(const uint8_t *previous)
+{
+  uint8_t rows = 0;
+  for (uint8_t row = 0; row < MAX7219_ROWS; row++)
+  {
+    if (memcmp(previous + row * DISPLAY_MODULES, mtrx.buffer + row * DISPLAY_MODULES, DISPLAY_MODULES) != 0)
+    {
+      rows++;
+    }
+  }
+  return rows;
+}
+
+/**
+ * Flips the frame and waits until it is out, returns the bytes sent
+ * after checking them against the bytes the simulated SPI saw.
+ */
+uint32_t flip_bytes()
+{
+  reset_display_bytes_sent();
+  uint64_t spi_bytes = sim_stats.spi_bytes;
+  display_flip();
+  display_wait();
+  TEST_ASSERT_EQUAL_UINT64(sim_stats.spi_bytes - spi_bytes, get_display_bytes_sent());
+  return get_display_bytes_sent();
+}
+
+void test_dirty_rows_only()
+{
+  digit_renderer_setup();
+  draw_fixed_digits(1234, 10, 4, 16);
+  flip_bytes();
+
+  // a changed digit sends its rows, a register/value pair per module
+  uint8_t previous[sizeof(mtrx.buffer)];
+  memcpy(previous, mtrx.buffer, sizeof(previous));
+  draw_fixed_digits(1235, 10, 4, 16);
+  uint8_t rows = changed_rows(previous);
+  TEST_ASSERT_GREATER_THAN(0, rows);
+  TEST_ASSERT_LESS_THAN(MAX7219_ROWS, rows);
+  TEST_ASSERT_EQUAL_UINT32(rows * 2 * DISPLAY_MODULES, flip_bytes());
+
+  // an unchanged frame doesn't touch the bus
+  TEST_ASSERT_EQUAL_UINT32(0, flip_bytes());
+
+  // a full update sends every row
+  set_update_mode(update_mode::full);
+  TEST_ASSERT_EQUAL_UINT32(MAX7219_ROWS * 2 * DISPLAY_MODULES, flip_bytes());
+  set_update_mode(update_mode::dirty);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_every_nibble_in_every_position);
+  RUN_TEST(test_many_timestamps);
+  RUN_TEST(test_dirty_rows_only);
+  return UNITY_END();
+}
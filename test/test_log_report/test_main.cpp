@@ -0,0 +1,78 @@
+/**
+ * Log records of the running firmware in the simulator: the periodic stats
+ * and the drift of every resync come out, none is dropped. Needs the
+ * records compiled in, pio test -e native_log.
+ */
+#include <unity.h>
+#include <Arduino.h>
+#include "debug_output.h"
+#include "application.h"
+#include "time_base.h"
+#include "hardware.h"
+
+// two resyncs after the one at boot
+#define RUN_SECONDS (2 * RTC_RESYNC_MINUTES * 60 + 100)
+
+uint16_t record_counts[LOG_MESSAGE_COUNT];
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Runs the firmware like the simulator does and counts the records of the
+ * serial output by id.
+ */
+void run_firmware()
+{
+  FILE *serial = tmpfile();
+  sim_serial_output(serial);
+  setup();
+  while (sim_now_us() < RUN_SECONDS * 1000000ULL)
+  {
+    loop();
+    sim_advance_to(sim_now_us() + SIM_LOOP_COST_US);
+  }
+  sim_serial_output(NULL);
+
+  rewind(serial);
+  int head;
+  while ((head = fgetc(serial)) != EOF)
+  {
+    TEST_ASSERT_EQUAL_HEX8(LOG_SYNC, head & 0xF0);
+    int id = fgetc(serial);
+    int argc = fgetc(serial);
+    TEST_ASSERT_TRUE(id >= 0 && id < LOG_MESSAGE_COUNT && argc >= 0 && argc <= 3);
+    record_counts[id]++;
+    fseek(serial, argc * sizeof(uint32_t), SEEK_CUR);
+  }
+  fclose(serial);
+}
+
+void test_stats_leave_room_for_drift()
+{
+#if LOG_LEVEL < LOG_LEVEL_INFO
+  TEST_IGNORE_MESSAGE("log records aren't compiled in, run pio test -e native_log");
+#else
+  run_firmware();
+  TEST_ASSERT_EQUAL_UINT16(0, get_log_dropped());
+  TEST_ASSERT_EQUAL_UINT16(2, record_counts[LOG_TIME_BASE_DRIFT]);
+
+  uint16_t periods = (RUN_SECONDS + POWER_REPORT_PERIOD - 1) / POWER_REPORT_PERIOD;
+  TEST_ASSERT_EQUAL_UINT16(periods, record_counts[LOG_POWER_STATS]);
+  TEST_ASSERT_EQUAL_UINT16(periods, record_counts[LOG_ANIMATION_STATS]);
+  TEST_ASSERT_EQUAL_UINT16(periods, record_counts[LOG_BUTTON_STATS]);
+  TEST_ASSERT_EQUAL_UINT16(periods, record_counts[LOG_MEMORY_STATS]);
+#endif
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_stats_leave_room_for_drift);
+  return UNITY_END();
+}
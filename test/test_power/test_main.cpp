@@ -0,0 +1,91 @@
+/**
+ * Duty accounting of the power module over sleep/wake cycles of the
+ * simulator, SQW calls power_tick() like the 1Hz handler of the firmware.
+ */
+#include <unity.h>
+#include "power.h"
+#include "hardware.h"
+
+#define CYCLES 100
+#define WORK_US 2000
+
+power_stats start;
+
+void setUp()
+{
+  // wakes on the next SQW edge, so every test starts at the beginning of a second
+  power_sleep(false);
+  start = get_power_stats();
+}
+
+void tearDown()
+{
+}
+
+void work(uint32_t us)
+{
+  sim_advance_to(sim_now_us() + us);
+}
+
+/**
+ * Work, then sleep until SQW: a second per cycle, awake only while working.
+ */
+void test_cycles_until_sqw()
+{
+  uint64_t started_us = sim_now_us();
+  for (uint16_t i = 0; i < CYCLES; i++)
+  {
+    work(WORK_US);
+    power_sleep(false);
+  }
+  power_stats stats = get_power_stats();
+  TEST_ASSERT_EQUAL_UINT64(CYCLES * 1000000ULL, sim_now_us() - started_us);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES * WORK_US, stats.awake_us - start.awake_us);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES, stats.sleeps - start.sleeps);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES, stats.seconds - start.seconds);
+}
+
+/**
+ * A wake requested before the sleep skips it, the time stays awake.
+ */
+void test_requested_wake_skips_sleep()
+{
+  for (uint16_t i = 0; i < CYCLES; i++)
+  {
+    work(WORK_US);
+    power_wake();
+    power_sleep(false);
+    work(WORK_US);
+    power_sleep(false);
+  }
+  power_stats stats = get_power_stats();
+  TEST_ASSERT_EQUAL_UINT32(2 * CYCLES * WORK_US, stats.awake_us - start.awake_us);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES, stats.sleeps - start.sleeps);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES, stats.seconds - start.seconds);
+}
+
+/**
+ * With the timer kept the Timer0 tick wakes every 1024 us, before SQW.
+ */
+void test_timer_wakes()
+{
+  for (uint16_t i = 0; i < CYCLES; i++)
+  {
+    power_sleep(true);
+  }
+  power_stats stats = get_power_stats();
+  TEST_ASSERT_EQUAL_UINT32(0, stats.awake_us - start.awake_us);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES, stats.sleeps - start.sleeps);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.seconds - start.seconds);
+}
+
+int main()
+{
+  sim_set_rtc(1700000000, false);
+  attachInterrupt(0, power_tick, FALLING);
+  UNITY_BEGIN();
+  RUN_TEST(test_cycles_until_sqw);
+  RUN_TEST(test_requested_wake_skips_sleep);
+  RUN_TEST(test_timer_wakes);
+  return UNITY_END();
+}
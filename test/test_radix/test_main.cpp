@@ -0,0 +1,132 @@
+/**
+ * Radix conversion against ultoa() and the division it replaces.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <ctype.h>
+#include "radix.h"
+
+const uint8_t BASES[] = {2, 8, 10, 16};
+
+uint32_t random_state = 1;
+
+uint32_t next_random()
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void check_convert(uint32_t value, uint8_t base)
+{
+  char expected[RADIX_TEXT_SIZE];
+  char text[RADIX_TEXT_SIZE];
+  ultoa(value, expected, base);
+  // ultoa() writes lower case, print() and radix_convert() upper case
+  for (char *p = expected; *p; p++)
+  {
+    *p = toupper(*p);
+  }
+  uint8_t length = radix_convert(value, base, text);
+
+  char message[48];
+  snprintf(message, sizeof(message), "%lu in base %u", (unsigned long)value, base);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, text, message);
+  TEST_ASSERT_EQUAL_MESSAGE(strlen(expected), length, message);
+}
+
+void test_small_values()
+{
+  for (uint8_t base : BASES)
+  {
+    for (uint32_t value = 0; value < 0x20000; value++)
+    {
+      check_convert(value, base);
+    }
+  }
+}
+
+/**
+ * Both sides of every digit count, where a length estimate would go wrong.
+ */
+void test_length_boundaries()
+{
+  for (uint8_t base : BASES)
+  {
+    for (uint64_t power = base; power <= 0xFFFFFFFF; power *= base)
+    {
+      for (int8_t delta = -2; delta <= 2; delta++)
+      {
+        check_convert(power + delta, base);
+      }
+    }
+    check_convert(0xFFFFFFFF, base);
+    check_convert(0xFFFFFFFE, base);
+    check_convert(0x80000000, base);
+  }
+}
+
+void test_random_values()
+{
+  for (uint32_t i = 0; i < 1000000; i++)
+  {
+    uint32_t value = next_random() >> (i & 31);
+    check_convert(value, BASES[i & 3]);
+  }
+}
+
+void test_unknown_base()
+{
+  char text[RADIX_TEXT_SIZE] = "x";
+  TEST_ASSERT_EQUAL(0, radix_convert(1234, 7, text));
+  TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+void check_div10(uint32_t value)
+{
+  uint8_t remainder;
+  uint32_t quotient = radix_div10(value, &remainder);
+  if (quotient != value / 10 || remainder != value % 10)
+  {
+    char message[48];
+    snprintf(message, sizeof(message), "%lu / 10", (unsigned long)value);
+    TEST_FAIL_MESSAGE(message);
+  }
+}
+
+/**
+ * A stride through the whole range and the ends of it, an exhaustive run
+ * over all 2^32 values passes too but takes too long for every test run.
+ */
+void test_div10()
+{
+  for (uint64_t value = 0; value <= 0xFFFFFFFF; value += 9973)
+  {
+    check_div10(value);
+  }
+  for (uint32_t value = 0; value < 1000000; value++)
+  {
+    check_div10(value);
+    check_div10(0xFFFFFFFF - value);
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_small_values);
+  RUN_TEST(test_length_boundaries);
+  RUN_TEST(test_random_values);
+  RUN_TEST(test_unknown_base);
+  RUN_TEST(test_div10);
+  return UNITY_END();
+}
@@ -0,0 +1,53 @@
+/**
+ * Boot with a DS3231 which never answers: the time base starts from the
+ * newest checkpoint, or from the build time without one.
+ */
+#include <unity.h>
+#include "rtc_clock.h"
+#include "time_base.h"
+#include "checkpoint.h"
+#include "hardware.h"
+
+// later than any build time
+#define CHECKPOINT_TIME 2000000000UL
+
+void setUp()
+{
+  sim_set_rtc_present(false);
+}
+
+void tearDown()
+{
+}
+
+void test_starts_from_build_time_without_checkpoint()
+{
+  checkpoint_setup();
+  uint32_t checkpoint;
+  TEST_ASSERT_FALSE(checkpoint_newest(&checkpoint));
+
+  rtc_setup();
+  time_base_resync();
+  uint32_t built = DateTime(F(__DATE__), F(__TIME__)).unixtime();
+  TEST_ASSERT_UINT32_WITHIN(3600, built, time_base_now());
+}
+
+void test_starts_from_newest_checkpoint()
+{
+  checkpoint_write(CHECKPOINT_TIME - CHECKPOINT_MINUTES * 60);
+  checkpoint_write(CHECKPOINT_TIME);
+  storage_flush();
+  checkpoint_setup();
+
+  rtc_setup();
+  time_base_resync();
+  TEST_ASSERT_EQUAL_UINT32(CHECKPOINT_TIME, time_base_now());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_starts_from_build_time_without_checkpoint);
+  RUN_TEST(test_starts_from_newest_checkpoint);
+  return UNITY_END();
+}
@@ -0,0 +1,210 @@
+/**
+ * Serial time sync protocol against the firmware running in the simulator,
+ * frames go in through the simulated RX line and replies are read back
+ * from its TX line.
+ */
+#include <unity.h>
+#include <Arduino.h>
+#include "serial_sync.h"
+#include "matrix_display.h"
+#include "time_zone.h"
+#include "hardware.h"
+
+struct sync_reply
+{
+  uint8_t command;
+  uint8_t status;
+  uint8_t size;
+  uint8_t payload[SYNC_PAYLOAD_MAX];
+};
+
+FILE *serial_out;
+long serial_read = 0;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Runs the main loop as the simulator does.
+ */
+void run_for_ms(uint32_t ms)
+{
+  uint64_t end = sim_now_us() + ms * 1000ULL;
+  while (sim_now_us() < end)
+  {
+    loop();
+    sim_advance_to(sim_now_us() + SIM_LOOP_COST_US);
+  }
+}
+
+void send_bytes(const uint8_t *bytes, uint8_t size)
+{
+  sim_serial_input(bytes, size);
+}
+
+void send_frame(uint8_t command, const uint8_t *payload, uint8_t size)
+{
+  uint8_t frame[4 + SYNC_PAYLOAD_MAX] = {SYNC_FRAME, command, size};
+  memcpy(frame + 3, payload, size);
+  frame[3 + size] = storage_crc8(frame + 1, 2 + size);
+  send_bytes(frame, 4 + size);
+}
+
+/**
+ * The next reply frame on the TX line, false if none came.
+ */
+bool receive_reply(sync_reply *reply)
+{
+  fflush(serial_out);
+  fseek(serial_out, serial_read, SEEK_SET);
+  uint8_t frame[3 + SYNC_PAYLOAD_MAX];
+  int c;
+  while ((c = fgetc(serial_out)) != EOF && c != SYNC_FRAME)
+  {
+  }
+  if (c == EOF || fread(frame, 1, 2, serial_out) != 2 || frame[1] < 1 || frame[1] > SYNC_PAYLOAD_MAX ||
+      fread(frame + 2, 1, frame[1] + 1, serial_out) != (size_t)frame[1] + 1)
+  {
+    return false;
+  }
+  serial_read = ftell(serial_out);
+  TEST_ASSERT_EQUAL_HEX8(storage_crc8(frame, 2 + frame[1]), frame[2 + frame[1]]);
+  reply->command = frame[0];
+  reply->status = frame[2];
+  reply->size = frame[1] - 1;
+  memcpy(reply->payload, frame + 3, reply->size);
+  return true;
+}
+
+sync_reply request(uint8_t command, const uint8_t *payload, uint8_t size)
+{
+  send_frame(command, payload, size);
+  run_for_ms(100);
+  sync_reply reply;
+  TEST_ASSERT_TRUE(receive_reply(&reply));
+  return reply;
+}
+
+void test_time_set_moves_the_ds3231()
+{
+  // the DS3231 second starts at the start of the second after next, 1000 s ahead
+  sync_time at = {time_base_now() + 2, 0};
+  uint8_t payload[10];
+  sync_put_time(sync_put(payload, at.seconds + 1000, 4), at);
+  int64_t offset = (int64_t)sim_rtc_unixtime() - (int64_t)(sim_now_us() / 1000000);
+
+  send_frame(sync_command::time_set, payload, sizeof(payload));
+  run_for_ms(3000);
+  sync_reply reply;
+  TEST_ASSERT_TRUE(receive_reply(&reply));
+  TEST_ASSERT_EQUAL_HEX8(sync_command::time_set | SYNC_REPLY, reply.command);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::accepted, reply.status);
+  TEST_ASSERT_EQUAL_UINT8(6, reply.size);
+  // the seconds byte is acknowledged at the moment, the loop looks about every millisecond
+  sync_time written = sync_get_time(reply.payload);
+  int64_t late = ((int64_t)written.seconds - at.seconds) * TIME_BASE_TICKS_PER_SECOND + written.ticks + RTC_SECONDS_ACK_TICKS;
+  TEST_ASSERT_TRUE(late >= 0 && late <= TIME_BASE_TICKS_PER_SECOND / 500);
+
+  run_for_ms(2000);
+  int64_t moved = (int64_t)sim_rtc_unixtime() - (int64_t)(sim_now_us() / 1000000) - offset;
+  TEST_ASSERT_TRUE(moved >= 999 && moved <= 1001);
+  TEST_ASSERT_UINT32_WITHIN(1, sim_rtc_unixtime(), time_base_now());
+}
+
+void test_mode_set_and_get()
+{
+  uint8_t mode = DISPLAY_MODE_COUNT - 1;
+  sync_reply reply = request(sync_command::mode_set, &mode, 1);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::accepted, reply.status);
+
+  reply = request(sync_command::mode_get, NULL, 0);
+  TEST_ASSERT_EQUAL_HEX8(sync_command::mode_get | SYNC_REPLY, reply.command);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::accepted, reply.status);
+  TEST_ASSERT_EQUAL_UINT8(2, reply.size);
+  TEST_ASSERT_EQUAL_UINT8(mode, reply.payload[0]);
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_MODE_COUNT, reply.payload[1]);
+}
+
+void test_bad_crc()
+{
+  uint8_t frame[] = {SYNC_FRAME, sync_command::mode_get, 0, 0};
+  frame[3] = storage_crc8(frame + 1, 2) ^ 0x01;
+  send_bytes(frame, sizeof(frame));
+  run_for_ms(100);
+  sync_reply reply;
+  TEST_ASSERT_TRUE(receive_reply(&reply));
+  TEST_ASSERT_EQUAL_HEX8(sync_command::mode_get | SYNC_REPLY, reply.command);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::bad_crc, reply.status);
+  TEST_ASSERT_EQUAL_UINT8(0, reply.size);
+}
+
+/**
+ * A frame cut short is dropped after SYNC_FRAME_SECONDS without a reply,
+ * the next one is taken as usual.
+ */
+void test_truncated_frame()
+{
+  uint8_t frame[] = {SYNC_FRAME, sync_command::epoch_set, 4, 0x12, 0x34};
+  send_bytes(frame, sizeof(frame));
+  run_for_ms((SYNC_FRAME_SECONDS + 2) * 1000UL);
+  sync_reply reply;
+  TEST_ASSERT_FALSE(receive_reply(&reply));
+
+  reply = request(sync_command::mode_get, NULL, 0);
+  TEST_ASSERT_EQUAL_HEX8(sync_command::mode_get | SYNC_REPLY, reply.command);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::accepted, reply.status);
+}
+
+void test_oversized_frame()
+{
+  uint8_t frame[] = {SYNC_FRAME, sync_command::mode_get, SYNC_PAYLOAD_MAX + 1};
+  send_bytes(frame, sizeof(frame));
+  run_for_ms(100);
+  sync_reply reply;
+  TEST_ASSERT_TRUE(receive_reply(&reply));
+  TEST_ASSERT_EQUAL_UINT8(sync_status::bad_size, reply.status);
+}
+
+void test_out_of_range_values()
+{
+  uint8_t mode = DISPLAY_MODE_COUNT;
+  sync_reply reply = request(sync_command::mode_set, &mode, 1);
+  TEST_ASSERT_EQUAL_HEX8(sync_command::mode_set | SYNC_REPLY, reply.command);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::bad_value, reply.status);
+
+  uint8_t zone = TIME_ZONE_COUNT;
+  reply = request(sync_command::zone_set, &zone, 1);
+  TEST_ASSERT_EQUAL_HEX8(sync_command::zone_set | SYNC_REPLY, reply.command);
+  TEST_ASSERT_EQUAL_UINT8(sync_status::bad_value, reply.status);
+
+  // the mode and zone stayed
+  reply = request(sync_command::mode_get, NULL, 0);
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_MODE_COUNT - 1, reply.payload[0]);
+  reply = request(sync_command::zone_get, NULL, 0);
+  TEST_ASSERT_TRUE(reply.payload[0] < TIME_ZONE_COUNT);
+}
+
+int main()
+{
+  sim_set_rtc(1700000000, false);
+  serial_out = tmpfile();
+  sim_serial_output(serial_out);
+  setup();
+  // until the 32K count locks, sub-second times read 0
+  run_for_ms(5000);
+  serial_read = ftell(serial_out);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_time_set_moves_the_ds3231);
+  RUN_TEST(test_mode_set_and_get);
+  RUN_TEST(test_bad_crc);
+  RUN_TEST(test_truncated_frame);
+  RUN_TEST(test_oversized_frame);
+  RUN_TEST(test_out_of_range_values);
+  return UNITY_END();
+}
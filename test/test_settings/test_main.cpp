@@ -0,0 +1,161 @@
+/**
+ * Loading the stored settings: the current record, the version 1 upgrade,
+ * the legacy layout before versioning, and the default mode of the list.
+ */
+#include <unity.h>
+#include "settings.h"
+#include "display_modes.h"
+#include "hardware.h"
+
+#define LEGACY_EPOCH 1234567890UL
+
+// stored bytes of a record, without the padding of the host build
+const uint8_t RECORD_SIZE = offsetof(settings_data, crc) + 1;
+
+void setUp()
+{
+  storage_flush();
+  uint8_t erased[CHECKPOINT_OFFSET];
+  memset(erased, 0xFF, sizeof(erased));
+  eeprom_update_block(erased, (void *)0, sizeof(erased));
+}
+
+void tearDown()
+{
+}
+
+void store_record(uint8_t version, uint8_t zone, uint8_t mode_index, uint32_t epoch_begin)
+{
+  settings_data record;
+  record.version = version;
+  record.zone = zone;
+  record.mode_index = mode_index;
+  record.brightness = 7;
+  record.epoch_begin = epoch_begin;
+  record.crc = storage_crc8(&record, offsetof(settings_data, crc));
+  eeprom_update_block(&record, (void *)SETTINGS_OFFSET, RECORD_SIZE);
+}
+
+/**
+ * The record in the EEPROM once the queued writes are out.
+ */
+settings_data stored_record()
+{
+  storage_flush();
+  settings_data record;
+  eeprom_read_block(&record, (const void *)SETTINGS_OFFSET, RECORD_SIZE);
+  TEST_ASSERT_EQUAL_HEX8(storage_crc8(&record, offsetof(settings_data, crc)), record.crc);
+  return record;
+}
+
+void test_current_record_loads_as_is()
+{
+  store_record(SETTINGS_VERSION, time_zone_from_hours(3), 1, LEGACY_EPOCH);
+  uint32_t writes = sim_stats.eeprom_writes;
+  settings_load();
+  TEST_ASSERT_EQUAL_UINT8(time_zone_from_hours(3), settings.zone);
+  TEST_ASSERT_EQUAL_UINT8(1, settings.mode_index);
+  TEST_ASSERT_EQUAL_UINT8(7, settings.brightness);
+  TEST_ASSERT_EQUAL_UINT32(LEGACY_EPOCH, settings.epoch_begin);
+  storage_flush();
+  TEST_ASSERT_EQUAL_UINT32(writes, sim_stats.eeprom_writes);
+}
+
+/**
+ * Version 1 kept a whole hour offset in the zone byte.
+ */
+void test_version_1_upgrades()
+{
+  const int8_t OFFSETS[] = {-11, -5, 0, 1, 12};
+  for (int8_t hours : OFFSETS)
+  {
+    setUp();
+    store_record(1, (uint8_t)hours, 2, LEGACY_EPOCH);
+    settings_load();
+    TEST_ASSERT_EQUAL_UINT8(SETTINGS_VERSION, settings.version);
+    TEST_ASSERT_EQUAL_UINT8(time_zone_from_hours(hours), settings.zone);
+    TEST_ASSERT_EQUAL_UINT8(2, settings.mode_index);
+    TEST_ASSERT_EQUAL_UINT8(7, settings.brightness);
+    TEST_ASSERT_EQUAL_UINT32(LEGACY_EPOCH, settings.epoch_begin);
+
+    settings_data stored = stored_record();
+    TEST_ASSERT_EQUAL_UINT8(SETTINGS_VERSION, stored.version);
+    TEST_ASSERT_EQUAL_UINT8(settings.zone, stored.zone);
+  }
+}
+
+/**
+ * Before versioning: the offset byte at EEPROM_GMT_OFFSET and the epoch
+ * at EEPROM_TIMESTAMP_OFFSET, the rest comes from the defaults.
+ */
+void test_legacy_layout_migrates()
+{
+  uint32_t epoch = LEGACY_EPOCH;
+  eeprom_update_byte((uint8_t *)EEPROM_GMT_OFFSET, (uint8_t)-3);
+  eeprom_update_block(&epoch, (void *)EEPROM_TIMESTAMP_OFFSET, sizeof(epoch));
+  settings_load();
+  TEST_ASSERT_EQUAL_UINT8(SETTINGS_VERSION, settings.version);
+  TEST_ASSERT_EQUAL_UINT8(time_zone_from_hours(-3), settings.zone);
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_MODE_DEFAULT, settings.mode_index);
+  TEST_ASSERT_EQUAL_UINT8(DEFAULT_BRIGHTNESS, settings.brightness);
+  TEST_ASSERT_EQUAL_UINT32(LEGACY_EPOCH, settings.epoch_begin);
+
+  settings_data stored = stored_record();
+  TEST_ASSERT_EQUAL_UINT8(SETTINGS_VERSION, stored.version);
+  TEST_ASSERT_EQUAL_UINT32(LEGACY_EPOCH, stored.epoch_begin);
+}
+
+void test_erased_eeprom_gets_defaults()
+{
+  settings_load();
+  TEST_ASSERT_EQUAL_UINT8(time_zone_from_hours(DEFAULT_TIMEZONE), settings.zone);
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_MODE_DEFAULT, settings.mode_index);
+  TEST_ASSERT_EQUAL_UINT32(EPOCH_BEGIN, settings.epoch_begin);
+  stored_record();
+}
+
+/**
+ * A torn record is not trusted, the legacy bytes are migrated instead.
+ */
+void test_bad_crc_falls_back_to_legacy()
+{
+  store_record(SETTINGS_VERSION, time_zone_from_hours(5), 1, 42);
+  eeprom_update_byte((uint8_t *)SETTINGS_OFFSET + offsetof(settings_data, epoch_begin), 43);
+  eeprom_update_byte((uint8_t *)EEPROM_GMT_OFFSET, 2);
+  settings_load();
+  TEST_ASSERT_EQUAL_UINT8(time_zone_from_hours(2), settings.zone);
+  TEST_ASSERT_EQUAL_UINT32(EPOCH_BEGIN, settings.epoch_begin);
+}
+
+struct first_mode
+{
+};
+
+struct second_mode
+{
+};
+
+struct third_mode
+{
+};
+
+void test_index_of_mode()
+{
+  typedef display_mode_list<first_mode, second_mode, third_mode> modes;
+  TEST_ASSERT_EQUAL_UINT8(0, modes::index_of<first_mode>());
+  TEST_ASSERT_EQUAL_UINT8(2, modes::index_of<third_mode>());
+  TEST_ASSERT_EQUAL_UINT8(2, (display_mode_list<first_mode, second_mode>::index_of<int>()));
+  TEST_ASSERT_TRUE(DISPLAY_MODE_DEFAULT < DISPLAY_MODE_COUNT);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_current_record_loads_as_is);
+  RUN_TEST(test_version_1_upgrades);
+  RUN_TEST(test_legacy_layout_migrates);
+  RUN_TEST(test_erased_eeprom_gets_defaults);
+  RUN_TEST(test_bad_crc_falls_back_to_legacy);
+  RUN_TEST(test_index_of_mode);
+  return UNITY_END();
+}
@@ -0,0 +1,88 @@
+/**
+ * EEPROM write queue on the simulated EEPROM, where a byte write takes
+ * 3.3 ms of virtual time and EE_READY fires as soon as it is enabled.
+ */
+#include <unity.h>
+#include "storage.h"
+#include "hardware.h"
+
+#define TEST_ADDRESS 0x100
+
+void setUp()
+{
+  storage_flush();
+}
+
+void tearDown()
+{
+}
+
+void fill(uint8_t *block, uint8_t size, uint8_t seed)
+{
+  for (uint8_t i = 0; i < size; i++)
+  {
+    block[i] = seed + i * 7;
+  }
+}
+
+void test_write_returns_at_once()
+{
+  uint8_t block[9];
+  fill(block, sizeof(block), sim_now_us());
+  uint64_t start = sim_now_us();
+  storage_write_block(block, TEST_ADDRESS, sizeof(block));
+  TEST_ASSERT_EQUAL_UINT32(0, sim_now_us() - start);
+
+  // rewriting while the first block is still going out doesn't wait either
+  block[0]++;
+  storage_write_block(block, TEST_ADDRESS, sizeof(block));
+  TEST_ASSERT_EQUAL_UINT32(0, sim_now_us() - start);
+}
+
+void test_reads_see_queued_bytes()
+{
+  uint8_t block[8];
+  uint8_t read[8];
+  fill(block, sizeof(block), 0x30);
+  storage_write_block(block, TEST_ADDRESS, sizeof(block));
+  storage_read_block(read, TEST_ADDRESS, sizeof(read));
+  TEST_ASSERT_EQUAL_MEMORY(block, read, sizeof(block));
+}
+
+void test_flush_writes_everything()
+{
+  uint8_t block[16];
+  uint8_t stored[16];
+  fill(block, sizeof(block), 0x50);
+  storage_write_block(block, TEST_ADDRESS, sizeof(block));
+  block[3] = 0xEE;
+  storage_write_byte(TEST_ADDRESS + 3, block[3]);
+  storage_flush();
+  eeprom_read_block(stored, (const void *)TEST_ADDRESS, sizeof(stored));
+  TEST_ASSERT_EQUAL_MEMORY(block, stored, sizeof(block));
+}
+
+/**
+ * Unchanged bytes are skipped, they cost neither a write nor time.
+ */
+void test_unchanged_bytes_take_no_time()
+{
+  uint8_t block[16];
+  fill(block, sizeof(block), 0x70);
+  storage_write_block(block, TEST_ADDRESS, sizeof(block));
+  storage_flush();
+  uint64_t start = sim_now_us();
+  storage_write_block(block, TEST_ADDRESS, sizeof(block));
+  storage_flush();
+  TEST_ASSERT_EQUAL_UINT32(0, sim_now_us() - start);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_write_returns_at_once);
+  RUN_TEST(test_reads_see_queued_bytes);
+  RUN_TEST(test_flush_writes_everything);
+  RUN_TEST(test_unchanged_bytes_take_no_time);
+  return UNITY_END();
+}
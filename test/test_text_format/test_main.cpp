@@ -0,0 +1,148 @@
+/**
+ * The text formatters against the sprintf() formats they replaced.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include "text_format.h"
+
+const uint32_t EDGES[] = {0, 1, 9, 10, 99, 100, 65535, 65536, 999999999, 1000000000, 2147483647, 2147483648U, 4294967295U};
+
+uint32_t random_state = 1;
+
+uint32_t next_random()
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void check_uint(uint32_t value)
+{
+  char expected[16];
+  char text[UINT32_TEXT_SIZE];
+  snprintf(expected, sizeof(expected), "%lu", (unsigned long)value);
+  format_uint(text, value);
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+
+  for (uint8_t width = 0; width <= 12; width += 3)
+  {
+    char padded[16];
+    snprintf(expected, sizeof(expected), "%0*lu", width, (unsigned long)value);
+    *put_uint(padded, value, width) = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, padded);
+  }
+}
+
+void check_int(int32_t value)
+{
+  char expected[16];
+  char text[INT32_TEXT_SIZE];
+  snprintf(expected, sizeof(expected), "%ld", (long)value);
+  format_int(text, value);
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+
+  for (uint8_t width = 0; width <= 12; width += 3)
+  {
+    char padded[16];
+    snprintf(expected, sizeof(expected), "%0*ld", width, (long)value);
+    *put_int(padded, value, width) = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, padded);
+  }
+}
+
+void test_uint_like_lu()
+{
+  for (uint32_t value : EDGES)
+  {
+    check_uint(value);
+  }
+  for (uint32_t i = 0; i < 200000; i++)
+  {
+    check_uint(next_random() >> (i & 31));
+  }
+}
+
+void test_int_like_ld()
+{
+  for (uint32_t value : EDGES)
+  {
+    check_int(value);
+    check_int(-(int32_t)value);
+  }
+  for (uint32_t i = 0; i < 200000; i++)
+  {
+    check_int((int32_t)next_random() >> (i & 31));
+  }
+}
+
+/**
+ * display_edit_epoch(), debug_output_unixtimestamp() and the time input screen.
+ */
+void check_date_time(civil_time time)
+{
+  char expected[32];
+  char text[DATE_TIME_TEXT_SIZE];
+
+  snprintf(expected, sizeof(expected), "%d/%d/%d %d:%d", time.year, time.mon, time.day, time.hour, time.min);
+  format_date_time(text, time, "// :", false);
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+
+  snprintf(expected, sizeof(expected), "%d:%d:%d:%d:%d", time.year, time.mon, time.day, time.hour, time.min);
+  format_date_time(text, time, "::::", false);
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+
+  snprintf(expected, sizeof(expected), "%04u/%02u/%02u %02u:%02u", time.year, time.mon, time.day, time.hour, time.min);
+  format_date_time(text, time, "// :", true);
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+void test_date_time_like_sprintf()
+{
+  civil_time widest = {65535, 255, 255, 255, 255, 255};
+  check_date_time(widest);
+  civil_time smallest = {0, 0, 0, 0, 0, 0};
+  check_date_time(smallest);
+  for (uint32_t i = 0; i < 100000; i++)
+  {
+    uint32_t r = next_random();
+    civil_time time = {(uint16_t)(1970 + r % 130), (uint8_t)(1 + (r >> 8) % 12), (uint8_t)(1 + (r >> 12) % 31),
+                       (uint8_t)((r >> 17) % 24), (uint8_t)((r >> 22) % 60), 0};
+    check_date_time(time);
+  }
+}
+
+void test_timezone_like_sprintf()
+{
+  const char *NAMES[] = {"", "UTC", "UTC+5:45", "Los Angeles"};
+  for (const char *name : NAMES)
+  {
+    char expected[32];
+    char text[TIMEZONE_TEXT_SIZE];
+    snprintf(expected, sizeof(expected), "TZ %s", name);
+    format_timezone(text, name);
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+  }
+  // longer names are cut to the buffer
+  char text[TIMEZONE_TEXT_SIZE];
+  format_timezone(text, "Somewhere very far");
+  TEST_ASSERT_EQUAL_STRING("TZ Somewhere v", text);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_uint_like_lu);
+  RUN_TEST(test_int_like_ld);
+  RUN_TEST(test_date_time_like_sprintf);
+  RUN_TEST(test_timezone_like_sprintf);
+  return UNITY_END();
+}
@@ -0,0 +1,329 @@
+/**
+ * Zone rules against reference instants of the tz database, for a zone of
+ * every DST region over several years, and the conversion of entered local
+ * times around the changes.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "time_zone.h"
+
+// a change, with the offsets in minutes before and after it
+struct zone_transition
+{
+  const char *zone;
+  uint32_t unix_time;
+  int16_t before;
+  int16_t after;
+};
+
+// an entered local time and its unix time, a repeated one on its second
+// pass, a skipped one with the offset after the change
+struct local_instant
+{
+  const char *zone;
+  uint32_t local_time;
+  uint32_t unix_time;
+};
+
+// generated with Python zoneinfo, the transitions of 2010, 2016, 2021, 2024, 2025 and 2031
+const zone_transition TRANSITIONS[] = {
+  {"London", 1269738000UL, 0, 60}, // 2010-03-28 01:00 UTC
+  {"London", 1288486800UL, 60, 0}, // 2010-10-31 01:00 UTC
+  {"London", 1459040400UL, 0, 60}, // 2016-03-27 01:00 UTC
+  {"London", 1477789200UL, 60, 0}, // 2016-10-30 01:00 UTC
+  {"London", 1616893200UL, 0, 60}, // 2021-03-28 01:00 UTC
+  {"London", 1635642000UL, 60, 0}, // 2021-10-31 01:00 UTC
+  {"London", 1711846800UL, 0, 60}, // 2024-03-31 01:00 UTC
+  {"London", 1729990800UL, 60, 0}, // 2024-10-27 01:00 UTC
+  {"London", 1743296400UL, 0, 60}, // 2025-03-30 01:00 UTC
+  {"London", 1761440400UL, 60, 0}, // 2025-10-26 01:00 UTC
+  {"London", 1932598800UL, 0, 60}, // 2031-03-30 01:00 UTC
+  {"London", 1950742800UL, 60, 0}, // 2031-10-26 01:00 UTC
+  {"Berlin", 1269738000UL, 60, 120}, // 2010-03-28 01:00 UTC
+  {"Berlin", 1288486800UL, 120, 60}, // 2010-10-31 01:00 UTC
+  {"Berlin", 1459040400UL, 60, 120}, // 2016-03-27 01:00 UTC
+  {"Berlin", 1477789200UL, 120, 60}, // 2016-10-30 01:00 UTC
+  {"Berlin", 1616893200UL, 60, 120}, // 2021-03-28 01:00 UTC
+  {"Berlin", 1635642000UL, 120, 60}, // 2021-10-31 01:00 UTC
+  {"Berlin", 1711846800UL, 60, 120}, // 2024-03-31 01:00 UTC
+  {"Berlin", 1729990800UL, 120, 60}, // 2024-10-27 01:00 UTC
+  {"Berlin", 1743296400UL, 60, 120}, // 2025-03-30 01:00 UTC
+  {"Berlin", 1761440400UL, 120, 60}, // 2025-10-26 01:00 UTC
+  {"Berlin", 1932598800UL, 60, 120}, // 2031-03-30 01:00 UTC
+  {"Berlin", 1950742800UL, 120, 60}, // 2031-10-26 01:00 UTC
+  {"New York", 1268550000UL, -300, -240}, // 2010-03-14 07:00 UTC
+  {"New York", 1289109600UL, -240, -300}, // 2010-11-07 06:00 UTC
+  {"New York", 1457852400UL, -300, -240}, // 2016-03-13 07:00 UTC
+  {"New York", 1478412000UL, -240, -300}, // 2016-11-06 06:00 UTC
+  {"New York", 1615705200UL, -300, -240}, // 2021-03-14 07:00 UTC
+  {"New York", 1636264800UL, -240, -300}, // 2021-11-07 06:00 UTC
+  {"New York", 1710054000UL, -300, -240}, // 2024-03-10 07:00 UTC
+  {"New York", 1730613600UL, -240, -300}, // 2024-11-03 06:00 UTC
+  {"New York", 1741503600UL, -300, -240}, // 2025-03-09 07:00 UTC
+  {"New York", 1762063200UL, -240, -300}, // 2025-11-02 06:00 UTC
+  {"New York", 1930806000UL, -300, -240}, // 2031-03-09 07:00 UTC
+  {"New York", 1951365600UL, -240, -300}, // 2031-11-02 06:00 UTC
+  {"Los Angeles", 1268560800UL, -480, -420}, // 2010-03-14 10:00 UTC
+  {"Los Angeles", 1289120400UL, -420, -480}, // 2010-11-07 09:00 UTC
+  {"Los Angeles", 1457863200UL, -480, -420}, // 2016-03-13 10:00 UTC
+  {"Los Angeles", 1478422800UL, -420, -480}, // 2016-11-06 09:00 UTC
+  {"Los Angeles", 1615716000UL, -480, -420}, // 2021-03-14 10:00 UTC
+  {"Los Angeles", 1636275600UL, -420, -480}, // 2021-11-07 09:00 UTC
+  {"Los Angeles", 1710064800UL, -480, -420}, // 2024-03-10 10:00 UTC
+  {"Los Angeles", 1730624400UL, -420, -480}, // 2024-11-03 09:00 UTC
+  {"Los Angeles", 1741514400UL, -480, -420}, // 2025-03-09 10:00 UTC
+  {"Los Angeles", 1762074000UL, -420, -480}, // 2025-11-02 09:00 UTC
+  {"Los Angeles", 1930816800UL, -480, -420}, // 2031-03-09 10:00 UTC
+  {"Los Angeles", 1951376400UL, -420, -480}, // 2031-11-02 09:00 UTC
+  {"Sydney", 1270310400UL, 660, 600}, // 2010-04-03 16:00 UTC
+  {"Sydney", 1286035200UL, 600, 660}, // 2010-10-02 16:00 UTC
+  {"Sydney", 1459612800UL, 660, 600}, // 2016-04-02 16:00 UTC
+  {"Sydney", 1475337600UL, 600, 660}, // 2016-10-01 16:00 UTC
+  {"Sydney", 1617465600UL, 660, 600}, // 2021-04-03 16:00 UTC
+  {"Sydney", 1633190400UL, 600, 660}, // 2021-10-02 16:00 UTC
+  {"Sydney", 1712419200UL, 660, 600}, // 2024-04-06 16:00 UTC
+  {"Sydney", 1728144000UL, 600, 660}, // 2024-10-05 16:00 UTC
+  {"Sydney", 1743868800UL, 660, 600}, // 2025-04-05 16:00 UTC
+  {"Sydney", 1759593600UL, 600, 660}, // 2025-10-04 16:00 UTC
+  {"Sydney", 1933171200UL, 660, 600}, // 2031-04-05 16:00 UTC
+  {"Sydney", 1948896000UL, 600, 660}, // 2031-10-04 16:00 UTC
+  {"Adelaide", 1270312200UL, 630, 570}, // 2010-04-03 16:30 UTC
+  {"Adelaide", 1286037000UL, 570, 630}, // 2010-10-02 16:30 UTC
+  {"Adelaide", 1459614600UL, 630, 570}, // 2016-04-02 16:30 UTC
+  {"Adelaide", 1475339400UL, 570, 630}, // 2016-10-01 16:30 UTC
+  {"Adelaide", 1617467400UL, 630, 570}, // 2021-04-03 16:30 UTC
+  {"Adelaide", 1633192200UL, 570, 630}, // 2021-10-02 16:30 UTC
+  {"Adelaide", 1712421000UL, 630, 570}, // 2024-04-06 16:30 UTC
+  {"Adelaide", 1728145800UL, 570, 630}, // 2024-10-05 16:30 UTC
+  {"Adelaide", 1743870600UL, 630, 570}, // 2025-04-05 16:30 UTC
+  {"Adelaide", 1759595400UL, 570, 630}, // 2025-10-04 16:30 UTC
+  {"Adelaide", 1933173000UL, 630, 570}, // 2031-04-05 16:30 UTC
+  {"Adelaide", 1948897800UL, 570, 630}, // 2031-10-04 16:30 UTC
+  {"Lord Howe", 1270306800UL, 660, 630}, // 2010-04-03 15:00 UTC
+  {"Lord Howe", 1286033400UL, 630, 660}, // 2010-10-02 15:30 UTC
+  {"Lord Howe", 1459609200UL, 660, 630}, // 2016-04-02 15:00 UTC
+  {"Lord Howe", 1475335800UL, 630, 660}, // 2016-10-01 15:30 UTC
+  {"Lord Howe", 1617462000UL, 660, 630}, // 2021-04-03 15:00 UTC
+  {"Lord Howe", 1633188600UL, 630, 660}, // 2021-10-02 15:30 UTC
+  {"Lord Howe", 1712415600UL, 660, 630}, // 2024-04-06 15:00 UTC
+  {"Lord Howe", 1728142200UL, 630, 660}, // 2024-10-05 15:30 UTC
+  {"Lord Howe", 1743865200UL, 660, 630}, // 2025-04-05 15:00 UTC
+  {"Lord Howe", 1759591800UL, 630, 660}, // 2025-10-04 15:30 UTC
+  {"Lord Howe", 1933167600UL, 660, 630}, // 2031-04-05 15:00 UTC
+  {"Lord Howe", 1948894200UL, 630, 660}, // 2031-10-04 15:30 UTC
+  {"Auckland", 1270303200UL, 780, 720}, // 2010-04-03 14:00 UTC
+  {"Auckland", 1285423200UL, 720, 780}, // 2010-09-25 14:00 UTC
+  {"Auckland", 1459605600UL, 780, 720}, // 2016-04-02 14:00 UTC
+  {"Auckland", 1474725600UL, 720, 780}, // 2016-09-24 14:00 UTC
+  {"Auckland", 1617458400UL, 780, 720}, // 2021-04-03 14:00 UTC
+  {"Auckland", 1632578400UL, 720, 780}, // 2021-09-25 14:00 UTC
+  {"Auckland", 1712412000UL, 780, 720}, // 2024-04-06 14:00 UTC
+  {"Auckland", 1727532000UL, 720, 780}, // 2024-09-28 14:00 UTC
+  {"Auckland", 1743861600UL, 780, 720}, // 2025-04-05 14:00 UTC
+  {"Auckland", 1758981600UL, 720, 780}, // 2025-09-27 14:00 UTC
+  {"Auckland", 1933164000UL, 780, 720}, // 2031-04-05 14:00 UTC
+  {"Auckland", 1948284000UL, 720, 780}, // 2031-09-27 14:00 UTC
+  {"Chatham", 1270303200UL, 825, 765}, // 2010-04-03 14:00 UTC
+  {"Chatham", 1285423200UL, 765, 825}, // 2010-09-25 14:00 UTC
+  {"Chatham", 1459605600UL, 825, 765}, // 2016-04-02 14:00 UTC
+  {"Chatham", 1474725600UL, 765, 825}, // 2016-09-24 14:00 UTC
+  {"Chatham", 1617458400UL, 825, 765}, // 2021-04-03 14:00 UTC
+  {"Chatham", 1632578400UL, 765, 825}, // 2021-09-25 14:00 UTC
+  {"Chatham", 1712412000UL, 825, 765}, // 2024-04-06 14:00 UTC
+  {"Chatham", 1727532000UL, 765, 825}, // 2024-09-28 14:00 UTC
+  {"Chatham", 1743861600UL, 825, 765}, // 2025-04-05 14:00 UTC
+  {"Chatham", 1758981600UL, 765, 825}, // 2025-09-27 14:00 UTC
+  {"Chatham", 1933164000UL, 825, 765}, // 2031-04-05 14:00 UTC
+  {"Chatham", 1948284000UL, 765, 825}, // 2031-09-27 14:00 UTC
+};
+
+// the second before, the middle of and the end of each skipped or repeated
+// span of 2024 and 2031, in local time
+const local_instant LOCAL_TIMES[] = {
+  {"London", 1711846799UL, 1711846799UL}, // 2024-03-31 00:59:59
+  {"London", 1711848600UL, 1711845000UL}, // 2024-03-31 01:30:00
+  {"London", 1711850400UL, 1711846800UL}, // 2024-03-31 02:00:00
+  {"London", 1729990799UL, 1729987199UL}, // 2024-10-27 00:59:59
+  {"London", 1729992600UL, 1729992600UL}, // 2024-10-27 01:30:00
+  {"London", 1729994400UL, 1729994400UL}, // 2024-10-27 02:00:00
+  {"London", 1932598799UL, 1932598799UL}, // 2031-03-30 00:59:59
+  {"London", 1932600600UL, 1932597000UL}, // 2031-03-30 01:30:00
+  {"London", 1932602400UL, 1932598800UL}, // 2031-03-30 02:00:00
+  {"London", 1950742799UL, 1950739199UL}, // 2031-10-26 00:59:59
+  {"London", 1950744600UL, 1950744600UL}, // 2031-10-26 01:30:00
+  {"London", 1950746400UL, 1950746400UL}, // 2031-10-26 02:00:00
+  {"Berlin", 1711850399UL, 1711846799UL}, // 2024-03-31 01:59:59
+  {"Berlin", 1711852200UL, 1711845000UL}, // 2024-03-31 02:30:00
+  {"Berlin", 1711854000UL, 1711846800UL}, // 2024-03-31 03:00:00
+  {"Berlin", 1729994399UL, 1729987199UL}, // 2024-10-27 01:59:59
+  {"Berlin", 1729996200UL, 1729992600UL}, // 2024-10-27 02:30:00
+  {"Berlin", 1729998000UL, 1729994400UL}, // 2024-10-27 03:00:00
+  {"Berlin", 1932602399UL, 1932598799UL}, // 2031-03-30 01:59:59
+  {"Berlin", 1932604200UL, 1932597000UL}, // 2031-03-30 02:30:00
+  {"Berlin", 1932606000UL, 1932598800UL}, // 2031-03-30 03:00:00
+  {"Berlin", 1950746399UL, 1950739199UL}, // 2031-10-26 01:59:59
+  {"Berlin", 1950748200UL, 1950744600UL}, // 2031-10-26 02:30:00
+  {"Berlin", 1950750000UL, 1950746400UL}, // 2031-10-26 03:00:00
+  {"New York", 1710035999UL, 1710053999UL}, // 2024-03-10 01:59:59
+  {"New York", 1710037800UL, 1710052200UL}, // 2024-03-10 02:30:00
+  {"New York", 1710039600UL, 1710054000UL}, // 2024-03-10 03:00:00
+  {"New York", 1730595599UL, 1730609999UL}, // 2024-11-03 00:59:59
+  {"New York", 1730597400UL, 1730615400UL}, // 2024-11-03 01:30:00
+  {"New York", 1730599200UL, 1730617200UL}, // 2024-11-03 02:00:00
+  {"New York", 1930787999UL, 1930805999UL}, // 2031-03-09 01:59:59
+  {"New York", 1930789800UL, 1930804200UL}, // 2031-03-09 02:30:00
+  {"New York", 1930791600UL, 1930806000UL}, // 2031-03-09 03:00:00
+  {"New York", 1951347599UL, 1951361999UL}, // 2031-11-02 00:59:59
+  {"New York", 1951349400UL, 1951367400UL}, // 2031-11-02 01:30:00
+  {"New York", 1951351200UL, 1951369200UL}, // 2031-11-02 02:00:00
+  {"Los Angeles", 1710035999UL, 1710064799UL}, // 2024-03-10 01:59:59
+  {"Los Angeles", 1710037800UL, 1710063000UL}, // 2024-03-10 02:30:00
+  {"Los Angeles", 1710039600UL, 1710064800UL}, // 2024-03-10 03:00:00
+  {"Los Angeles", 1730595599UL, 1730620799UL}, // 2024-11-03 00:59:59
+  {"Los Angeles", 1730597400UL, 1730626200UL}, // 2024-11-03 01:30:00
+  {"Los Angeles", 1730599200UL, 1730628000UL}, // 2024-11-03 02:00:00
+  {"Los Angeles", 1930787999UL, 1930816799UL}, // 2031-03-09 01:59:59
+  {"Los Angeles", 1930789800UL, 1930815000UL}, // 2031-03-09 02:30:00
+  {"Los Angeles", 1930791600UL, 1930816800UL}, // 2031-03-09 03:00:00
+  {"Los Angeles", 1951347599UL, 1951372799UL}, // 2031-11-02 00:59:59
+  {"Los Angeles", 1951349400UL, 1951378200UL}, // 2031-11-02 01:30:00
+  {"Los Angeles", 1951351200UL, 1951380000UL}, // 2031-11-02 02:00:00
+  {"Sydney", 1712455199UL, 1712415599UL}, // 2024-04-07 01:59:59
+  {"Sydney", 1712457000UL, 1712421000UL}, // 2024-04-07 02:30:00
+  {"Sydney", 1712458800UL, 1712422800UL}, // 2024-04-07 03:00:00
+  {"Sydney", 1728179999UL, 1728143999UL}, // 2024-10-06 01:59:59
+  {"Sydney", 1728181800UL, 1728142200UL}, // 2024-10-06 02:30:00
+  {"Sydney", 1728183600UL, 1728144000UL}, // 2024-10-06 03:00:00
+  {"Sydney", 1933207199UL, 1933167599UL}, // 2031-04-06 01:59:59
+  {"Sydney", 1933209000UL, 1933173000UL}, // 2031-04-06 02:30:00
+  {"Sydney", 1933210800UL, 1933174800UL}, // 2031-04-06 03:00:00
+  {"Sydney", 1948931999UL, 1948895999UL}, // 2031-10-05 01:59:59
+  {"Sydney", 1948933800UL, 1948894200UL}, // 2031-10-05 02:30:00
+  {"Sydney", 1948935600UL, 1948896000UL}, // 2031-10-05 03:00:00
+  {"Adelaide", 1712455199UL, 1712417399UL}, // 2024-04-07 01:59:59
+  {"Adelaide", 1712457000UL, 1712422800UL}, // 2024-04-07 02:30:00
+  {"Adelaide", 1712458800UL, 1712424600UL}, // 2024-04-07 03:00:00
+  {"Adelaide", 1728179999UL, 1728145799UL}, // 2024-10-06 01:59:59
+  {"Adelaide", 1728181800UL, 1728144000UL}, // 2024-10-06 02:30:00
+  {"Adelaide", 1728183600UL, 1728145800UL}, // 2024-10-06 03:00:00
+  {"Adelaide", 1933207199UL, 1933169399UL}, // 2031-04-06 01:59:59
+  {"Adelaide", 1933209000UL, 1933174800UL}, // 2031-04-06 02:30:00
+  {"Adelaide", 1933210800UL, 1933176600UL}, // 2031-04-06 03:00:00
+  {"Adelaide", 1948931999UL, 1948897799UL}, // 2031-10-05 01:59:59
+  {"Adelaide", 1948933800UL, 1948896000UL}, // 2031-10-05 02:30:00
+  {"Adelaide", 1948935600UL, 1948897800UL}, // 2031-10-05 03:00:00
+  {"Lord Howe", 1712453399UL, 1712413799UL}, // 2024-04-07 01:29:59
+  {"Lord Howe", 1712454300UL, 1712416500UL}, // 2024-04-07 01:45:00
+  {"Lord Howe", 1712455200UL, 1712417400UL}, // 2024-04-07 02:00:00
+  {"Lord Howe", 1728179999UL, 1728142199UL}, // 2024-10-06 01:59:59
+  {"Lord Howe", 1728180900UL, 1728141300UL}, // 2024-10-06 02:15:00
+  {"Lord Howe", 1728181800UL, 1728142200UL}, // 2024-10-06 02:30:00
+  {"Lord Howe", 1933205399UL, 1933165799UL}, // 2031-04-06 01:29:59
+  {"Lord Howe", 1933206300UL, 1933168500UL}, // 2031-04-06 01:45:00
+  {"Lord Howe", 1933207200UL, 1933169400UL}, // 2031-04-06 02:00:00
+  {"Lord Howe", 1948931999UL, 1948894199UL}, // 2031-10-05 01:59:59
+  {"Lord Howe", 1948932900UL, 1948893300UL}, // 2031-10-05 02:15:00
+  {"Lord Howe", 1948933800UL, 1948894200UL}, // 2031-10-05 02:30:00
+  {"Auckland", 1712455199UL, 1712408399UL}, // 2024-04-07 01:59:59
+  {"Auckland", 1712457000UL, 1712413800UL}, // 2024-04-07 02:30:00
+  {"Auckland", 1712458800UL, 1712415600UL}, // 2024-04-07 03:00:00
+  {"Auckland", 1727575199UL, 1727531999UL}, // 2024-09-29 01:59:59
+  {"Auckland", 1727577000UL, 1727530200UL}, // 2024-09-29 02:30:00
+  {"Auckland", 1727578800UL, 1727532000UL}, // 2024-09-29 03:00:00
+  {"Auckland", 1933207199UL, 1933160399UL}, // 2031-04-06 01:59:59
+  {"Auckland", 1933209000UL, 1933165800UL}, // 2031-04-06 02:30:00
+  {"Auckland", 1933210800UL, 1933167600UL}, // 2031-04-06 03:00:00
+  {"Auckland", 1948327199UL, 1948283999UL}, // 2031-09-28 01:59:59
+  {"Auckland", 1948329000UL, 1948282200UL}, // 2031-09-28 02:30:00
+  {"Auckland", 1948330800UL, 1948284000UL}, // 2031-09-28 03:00:00
+  {"Chatham", 1712457899UL, 1712408399UL}, // 2024-04-07 02:44:59
+  {"Chatham", 1712459700UL, 1712413800UL}, // 2024-04-07 03:15:00
+  {"Chatham", 1712461500UL, 1712415600UL}, // 2024-04-07 03:45:00
+  {"Chatham", 1727577899UL, 1727531999UL}, // 2024-09-29 02:44:59
+  {"Chatham", 1727579700UL, 1727530200UL}, // 2024-09-29 03:15:00
+  {"Chatham", 1727581500UL, 1727532000UL}, // 2024-09-29 03:45:00
+  {"Chatham", 1933209899UL, 1933160399UL}, // 2031-04-06 02:44:59
+  {"Chatham", 1933211700UL, 1933165800UL}, // 2031-04-06 03:15:00
+  {"Chatham", 1933213500UL, 1933167600UL}, // 2031-04-06 03:45:00
+  {"Chatham", 1948329899UL, 1948283999UL}, // 2031-09-28 02:44:59
+  {"Chatham", 1948331700UL, 1948282200UL}, // 2031-09-28 03:15:00
+  {"Chatham", 1948333500UL, 1948284000UL}, // 2031-09-28 03:45:00
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+uint8_t find_zone(const char *name)
+{
+  for (uint8_t zone = 0; zone < TIME_ZONE_COUNT; zone++)
+  {
+    char zone_name[TIME_ZONE_NAME_SIZE];
+    time_zone_name(zone_name, zone);
+    if (strcmp(zone_name, name) == 0)
+    {
+      return zone;
+    }
+  }
+  TEST_FAIL_MESSAGE(name);
+  return 0;
+}
+
+void test_offsets_around_transitions()
+{
+  for (const zone_transition &transition : TRANSITIONS)
+  {
+    uint8_t zone = find_zone(transition.zone);
+    char message[48];
+    snprintf(message, sizeof(message), "%s at %lu", transition.zone, (unsigned long)transition.unix_time);
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(transition.before * 60L, time_zone_offset_at(zone, transition.unix_time - 1), message);
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(transition.after * 60L, time_zone_offset_at(zone, transition.unix_time), message);
+  }
+}
+
+/**
+ * The cached state changes exactly at the transitions.
+ */
+void test_update_follows_transitions()
+{
+  for (const zone_transition &transition : TRANSITIONS)
+  {
+    char message[48];
+    snprintf(message, sizeof(message), "%s at %lu", transition.zone, (unsigned long)transition.unix_time);
+    time_zone_select(find_zone(transition.zone), transition.unix_time - 3600);
+    time_zone_update(transition.unix_time - 1);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(transition.unix_time - 1 + transition.before * 60L,
+                                     time_zone_local(transition.unix_time - 1), message);
+    time_zone_update(transition.unix_time);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(transition.unix_time + transition.after * 60L,
+                                     time_zone_local(transition.unix_time), message);
+  }
+}
+
+/**
+ * Before, inside and after the skipped and the repeated local times.
+ */
+void test_local_to_utc()
+{
+  for (const local_instant &instant : LOCAL_TIMES)
+  {
+    char message[48];
+    snprintf(message, sizeof(message), "%s local %lu", instant.zone, (unsigned long)instant.local_time);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(instant.unix_time, time_zone_to_utc(find_zone(instant.zone), instant.local_time),
+                                     message);
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_offsets_around_transitions);
+  RUN_TEST(test_update_follows_transitions);
+  RUN_TEST(test_local_to_utc);
+  return UNITY_END();
+}
@@ -0,0 +1,493 @@
+/*
+ * Runs the firmware image under simavr and prints cycle counts as JSON.
+ *
+ *     bench firmware.elf > report.json
+ *
+ * Modelled around the ATmega328: a DS3231 on TWI (time registers only), its
+ * 1 Hz SQW on D2, buttons on D6/D7/D8 and the MAX7219 chain as a sink for
+ * SPI with its CS on D10. The bench build gives Timer1 to the profiler, so
+ * the 32K output isn't modelled and fractional modes draw a zero fraction. Everything is counted in CPU cycles of the
+ * simulated 16 MHz core, so results do not depend on the host.
+ *
+ * boot            reset -> first sleep, setup_app() as a whole
+ * sqw_to_latch.*  SQW edge -> last CS rise before the CPU sleeps again, per
+ *                 display mode; edge -> sleep when no row changed
+ * display_bin,
+ * user_input_redraw
+ *                 taken from the PROFILE table the firmware prints on 'p'
+ * radix.*         radix_convert() per base over values of 1 to 32 bits,
+ *                 run by 'c' before the dump
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_twi.h"
+#include "avr_uart.h"
+
+#define BENCH_FREQUENCY 16000000UL
+#define BENCH_START_TIME 1700000000UL
+#define DS3231_ADDRESS 0xD0
+#define DS3231_REGISTERS 0x13
+#define SQW_SAMPLES 8
+#define CLICK_MS 100
+#define UART_CAPTURE_SIZE 2048
+
+/* the default DISPLAY_MODES */
+enum { MODE_BIN, MODE_OCT, MODE_DEC, MODE_HEX, MODE_STR, MODE_BIN_FRACTION, MODE_HEX_MILLIS, MODE_COUNT, MODE_NONE = MODE_COUNT };
+
+static const char *MODE_NAMES[MODE_COUNT] = {"bin", "oct", "dec", "hex", "str", "bin_fraction", "hex_millis"};
+
+#define RADIX_COUNT 4
+static const char *RADIX_REGIONS[RADIX_COUNT] = {"RADIX_BIN", "RADIX_OCT", "RADIX_DEC", "RADIX_HEX"};
+static const char *RADIX_NAMES[RADIX_COUNT] = {"radix.bin", "radix.oct", "radix.dec", "radix.hex"};
+
+struct sample_stats
+{
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  uint32_t count;
+};
+
+static avr_t *avr;
+
+/* DS3231 */
+static avr_irq_t *rtc_irq;
+static uint8_t rtc_selected;
+static uint8_t rtc_pointer;
+static int rtc_pointer_written;
+static uint8_t rtc_registers[DS3231_REGISTERS];
+static int64_t rtc_offset;
+
+/* SQW edge -> latch */
+static avr_irq_t *sqw_irq;
+static uint8_t sqw_level = 1;
+static avr_cycle_count_t edge_cycle;
+static avr_cycle_count_t latch_cycle;
+static int edge_pending;
+static int edge_settled;
+static int measured_mode = MODE_NONE;
+static struct sample_stats sqw_stats[MODE_COUNT];
+
+/* UART */
+static char uart_capture[UART_CAPTURE_SIZE];
+static size_t uart_length;
+
+static uint64_t cycles_from_ms(uint32_t ms)
+{
+  return (uint64_t)ms * (BENCH_FREQUENCY / 1000);
+}
+
+static void stats_add(struct sample_stats *stats, uint64_t value)
+{
+  if (stats->count == 0 || value < stats->min)
+  {
+    stats->min = value;
+  }
+  if (value > stats->max)
+  {
+    stats->max = value;
+  }
+  stats->sum += value;
+  stats->count++;
+}
+
+static uint8_t to_bcd(unsigned value)
+{
+  return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+static unsigned from_bcd(uint8_t value)
+{
+  return (value >> 4) * 10 + (value & 0x0F);
+}
+
+static time_t rtc_unixtime()
+{
+  return (time_t)((int64_t)(avr->cycle / BENCH_FREQUENCY) + BENCH_START_TIME + rtc_offset);
+}
+
+static void rtc_latch_time()
+{
+  time_t now = rtc_unixtime();
+  struct tm civil;
+  gmtime_r(&now, &civil);
+  rtc_registers[0] = to_bcd(civil.tm_sec);
+  rtc_registers[1] = to_bcd(civil.tm_min);
+  rtc_registers[2] = to_bcd(civil.tm_hour);
+  rtc_registers[3] = to_bcd(civil.tm_wday + 1);
+  rtc_registers[4] = to_bcd(civil.tm_mday);
+  rtc_registers[5] = to_bcd(civil.tm_mon + 1);
+  rtc_registers[6] = to_bcd(civil.tm_year - 100);
+}
+
+/* A write to the seconds..year block is rtc.adjust(), applied when the
+ * transaction stops. */
+static void rtc_store_time()
+{
+  struct tm civil;
+  memset(&civil, 0, sizeof(civil));
+  civil.tm_sec = from_bcd(rtc_registers[0]);
+  civil.tm_min = from_bcd(rtc_registers[1]);
+  civil.tm_hour = from_bcd(rtc_registers[2] & 0x3F);
+  civil.tm_mday = from_bcd(rtc_registers[4]);
+  civil.tm_mon = from_bcd(rtc_registers[5] & 0x1F) - 1;
+  civil.tm_year = from_bcd(rtc_registers[6]) + 100;
+  rtc_offset += (int64_t)timegm(&civil) - (int64_t)rtc_unixtime();
+}
+
+static void rtc_twi_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  static int time_written;
+  avr_twi_msg_irq_t message;
+  message.u.v = value;
+
+  if (message.u.twi.msg & TWI_COND_STOP)
+  {
+    if (time_written)
+    {
+      rtc_store_time();
+    }
+    time_written = 0;
+    rtc_selected = 0;
+  }
+  if (message.u.twi.msg & TWI_COND_START)
+  {
+    rtc_selected = 0;
+    if ((message.u.twi.addr & 0xFE) == DS3231_ADDRESS)
+    {
+      rtc_selected = message.u.twi.addr;
+      rtc_pointer_written = 0;
+      rtc_latch_time();
+      avr_raise_irq(rtc_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, rtc_selected, 1));
+    }
+  }
+  if (!rtc_selected)
+  {
+    return;
+  }
+  if (message.u.twi.msg & TWI_COND_WRITE)
+  {
+    avr_raise_irq(rtc_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, rtc_selected, 1));
+    if (!rtc_pointer_written)
+    {
+      rtc_pointer = message.u.twi.data % DS3231_REGISTERS;
+      rtc_pointer_written = 1;
+    }
+    else
+    {
+      rtc_registers[rtc_pointer] = message.u.twi.data;
+      time_written |= rtc_pointer <= 6;
+      rtc_pointer = (rtc_pointer + 1) % DS3231_REGISTERS;
+    }
+  }
+  if (message.u.twi.msg & TWI_COND_READ)
+  {
+    avr_raise_irq(rtc_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_READ, rtc_selected, rtc_registers[rtc_pointer]));
+    rtc_pointer = (rtc_pointer + 1) % DS3231_REGISTERS;
+  }
+}
+
+static void rtc_attach()
+{
+  static const char *names[2] = {"8>ds3231.out", "32<ds3231.in"};
+  rtc_irq = avr_alloc_irq(&avr->irq_pool, 0, 2, names);
+  avr_irq_register_notify(rtc_irq + TWI_IRQ_OUTPUT, rtc_twi_hook, NULL);
+  avr_connect_irq(rtc_irq + TWI_IRQ_INPUT, avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+  avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), rtc_irq + TWI_IRQ_OUTPUT);
+}
+
+/* Closes the sample of the previous edge, the firmware had a whole second. */
+static void sqw_close_sample()
+{
+  if (edge_pending && measured_mode != MODE_NONE)
+  {
+    stats_add(&sqw_stats[measured_mode], latch_cycle - edge_cycle);
+  }
+  edge_pending = 0;
+}
+
+/* SQW is a 50 % square wave, the firmware counts falling edges. */
+static avr_cycle_count_t sqw_toggle(struct avr_t *avr, avr_cycle_count_t when, void *param)
+{
+  sqw_level = !sqw_level;
+  if (!sqw_level)
+  {
+    sqw_close_sample();
+    edge_cycle = avr->cycle;
+    latch_cycle = avr->cycle;
+    edge_pending = 1;
+    edge_settled = 0;
+  }
+  avr_raise_irq(sqw_irq, sqw_level);
+  return when + BENCH_FREQUENCY / 2;
+}
+
+static void cs_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  if (value && edge_pending && !edge_settled)
+  {
+    latch_cycle = avr->cycle;
+  }
+}
+
+static void uart_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  if (uart_length < UART_CAPTURE_SIZE - 1)
+  {
+    uart_capture[uart_length++] = (char)value;
+    uart_capture[uart_length] = 0;
+  }
+}
+
+static void uart_send(char c)
+{
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT), (uint8_t)c);
+}
+
+static void uart_attach()
+{
+  uint32_t flags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uart_hook, NULL);
+}
+
+/* Runs the core until the cycle counter passes target, tracking sleeps. */
+static int run_until(avr_cycle_count_t target)
+{
+  while (avr->cycle < target)
+  {
+    int state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed)
+    {
+      return 0;
+    }
+    if (state == cpu_Sleeping && edge_pending && !edge_settled)
+    {
+      if (latch_cycle == edge_cycle)
+      {
+        latch_cycle = avr->cycle;
+      }
+      edge_settled = 1;
+    }
+  }
+  return 1;
+}
+
+static int run_ms(uint32_t ms)
+{
+  return run_until(avr->cycle + cycles_from_ms(ms));
+}
+
+static int run_until_sleep(avr_cycle_count_t limit)
+{
+  while (avr->cycle < limit)
+  {
+    int state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed)
+    {
+      return 0;
+    }
+    if (state == cpu_Sleeping)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static avr_irq_t *pin_irq(char port, int bit)
+{
+  return avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit);
+}
+
+/* Buttons are active low with pull-ups, the decoder wants a debounced press. */
+static int click(avr_irq_t *button)
+{
+  avr_raise_irq(button, 0);
+  int running = run_ms(CLICK_MS);
+  avr_raise_irq(button, 1);
+  return running && run_ms(600);
+}
+
+static int parse_profile(const char *region, struct sample_stats *stats, unsigned long *mean)
+{
+  char pattern[48];
+  snprintf(pattern, sizeof(pattern), "\n%s ", region);
+  const char *line = strstr(uart_capture, pattern);
+  if (!line)
+  {
+    return 0;
+  }
+  unsigned long count, min, max;
+  if (sscanf(line + strlen(pattern), "%lu %lu %lu %lu", &count, &min, &max, mean) != 4)
+  {
+    return 0;
+  }
+  stats->count = count;
+  stats->min = min;
+  stats->max = max;
+  return 1;
+}
+
+static void print_stats(const char *name, const struct sample_stats *stats, unsigned long mean, int last)
+{
+  printf("  \"%s\": {\"count\": %u, \"min\": %llu, \"max\": %llu, \"mean\": %lu}%s\n",
+         name, stats->count, (unsigned long long)stats->min, (unsigned long long)stats->max, mean, last ? "" : ",");
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s firmware.elf\n", argv[0]);
+    return 2;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(argv[1], &firmware) != 0)
+  {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 2;
+  }
+  strcpy(firmware.mmcu, "atmega328p");
+  firmware.frequency = BENCH_FREQUENCY;
+
+  avr = avr_make_mcu_by_name(firmware.mmcu);
+  if (!avr)
+  {
+    fprintf(stderr, "simavr has no %s core\n", firmware.mmcu);
+    return 2;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+  avr->log = LOG_ERROR;
+
+  rtc_attach();
+  uart_attach();
+  avr_irq_register_notify(pin_irq('B', 2), cs_hook, NULL);
+  avr_irq_t *mode_button = pin_irq('D', 6);
+  avr_irq_t *choose_button = pin_irq('D', 7);
+  avr_irq_t *settings_button = pin_irq('B', 0);
+  avr_raise_irq(mode_button, 1);
+  avr_raise_irq(choose_button, 1);
+  avr_raise_irq(settings_button, 1);
+  sqw_irq = pin_irq('D', 2);
+  avr_raise_irq(sqw_irq, sqw_level);
+
+  struct sample_stats boot = {0};
+  if (!run_until_sleep(cycles_from_ms(5000)))
+  {
+    fprintf(stderr, "firmware did not reach sleep after reset\n");
+    return 1;
+  }
+  stats_add(&boot, avr->cycle);
+
+  // the first edge lands mid-second so setup and first draw are not counted
+  avr_cycle_timer_register(avr, BENCH_FREQUENCY / 4, sqw_toggle, NULL);
+  if (!run_ms(2000))
+  {
+    return 1;
+  }
+  uart_send('r');
+
+  // the firmware starts in str, the mode button goes on from there and wraps
+  static const int MODE_ORDER[MODE_COUNT] = {MODE_STR, MODE_BIN_FRACTION, MODE_HEX_MILLIS, MODE_BIN, MODE_OCT, MODE_DEC, MODE_HEX};
+  for (int i = 0; i < MODE_COUNT; i++)
+  {
+    if (i > 0 && !click(mode_button))
+    {
+      return 1;
+    }
+    // skip the edge that redraws the whole face for the new mode
+    if (!run_ms(1000))
+    {
+      return 1;
+    }
+    edge_pending = 0;
+    measured_mode = MODE_ORDER[i];
+    if (!run_ms(SQW_SAMPLES * 1000))
+    {
+      return 1;
+    }
+    sqw_close_sample();
+    measured_mode = MODE_NONE;
+  }
+
+  // settings -> current time -> a few increments, then let the menu time out
+  if (!click(settings_button) || !click(choose_button))
+  {
+    return 1;
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    if (!click(choose_button))
+    {
+      return 1;
+    }
+  }
+  if (!run_ms(60000))
+  {
+    return 1;
+  }
+
+  uart_send('c');
+  if (!run_ms(100))
+  {
+    return 1;
+  }
+  uart_length = 0;
+  uart_capture[uart_length++] = '\n';
+  uart_send('p');
+  if (!run_ms(1000))
+  {
+    return 1;
+  }
+
+  struct sample_stats display_bin = {0}, user_input_redraw = {0};
+  unsigned long display_bin_mean = 0, user_input_redraw_mean = 0;
+  if (!parse_profile("DISPLAY_BIN", &display_bin, &display_bin_mean) ||
+      !parse_profile("USER_INPUT_REDRAW", &user_input_redraw, &user_input_redraw_mean))
+  {
+    fprintf(stderr, "no profiler dump, was the image built with -D PROFILE?\n%s\n", uart_capture);
+    return 1;
+  }
+  struct sample_stats radix[RADIX_COUNT] = {{0}};
+  unsigned long radix_mean[RADIX_COUNT] = {0};
+  for (int i = 0; i < RADIX_COUNT; i++)
+  {
+    if (!parse_profile(RADIX_REGIONS[i], &radix[i], &radix_mean[i]))
+    {
+      fprintf(stderr, "no %s in the profiler dump\n%s\n", RADIX_REGIONS[i], uart_capture);
+      return 1;
+    }
+  }
+
+  printf("{\n");
+  print_stats("boot", &boot, (unsigned long)boot.sum, 0);
+  for (int i = 0; i < MODE_COUNT; i++)
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "sqw_to_latch.%s", MODE_NAMES[i]);
+    const struct sample_stats *stats = &sqw_stats[i];
+    print_stats(name, stats, stats->count ? (unsigned long)(stats->sum / stats->count) : 0, 0);
+  }
+  print_stats("display_bin", &display_bin, display_bin_mean, 0);
+  print_stats("user_input_redraw", &user_input_redraw, user_input_redraw_mean, 0);
+  for (int i = 0; i < RADIX_COUNT; i++)
+  {
+    print_stats(RADIX_NAMES[i], &radix[i], radix_mean[i], i == RADIX_COUNT - 1);
+  }
+  printf("}\n");
+  return 0;
+}
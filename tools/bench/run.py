@@ -0,0 +1,97 @@
+"""
+Builds the bench firmware, runs it under simavr and compares the cycle counts
+with the stored baseline.
+
+    python tools/bench/run.py                    # fails on a regression
+    python tools/bench/run.py --update-baseline  # accepts the current numbers
+    python tools/bench/run.py --measured R.json  # compares a report of another run
+
+A metric regresses when its mean or max grows by more than the threshold of
+the baseline (5 % unless the baseline says otherwise). Without a baseline the
+run fails, --update-baseline records one to commit.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(BENCH_DIR))
+FIRMWARE = os.path.join(ROOT, ".pio", "build", "bench", "firmware.elf")
+BASELINE = os.path.join(BENCH_DIR, "baseline.json")
+DEFAULT_THRESHOLD = 0.05
+COMPARED = ("mean", "max")
+
+
+def build():
+    subprocess.run(["pio", "run", "-e", "bench"], cwd=ROOT, check=True)
+    subprocess.run(["make", "-C", BENCH_DIR, "bench"], check=True)
+
+
+def measure():
+    output = subprocess.run([os.path.join(BENCH_DIR, "bench"), FIRMWARE],
+                            check=True, capture_output=True, text=True).stdout
+    return json.loads(output)
+
+
+def compare(report, baseline):
+    threshold = baseline.get("threshold", DEFAULT_THRESHOLD)
+    regressions = []
+    for name, metric in sorted(report.items()):
+        reference = baseline["metrics"].get(name)
+        for key in COMPARED:
+            value = metric[key]
+            if reference is None:
+                print("{:28} {:4} {:>10}  (new)".format(name, key, value))
+                continue
+            limit = reference[key] * (1 + threshold)
+            change = (value - reference[key]) / reference[key] * 100 if reference[key] else 0.0
+            failed = value > limit
+            print("{:28} {:4} {:>10} {:>+7.1f}%{}".format(name, key, value, change, "  REGRESSION" if failed else ""))
+            if failed:
+                regressions.append(name)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--update-baseline", action="store_true")
+    parser.add_argument("--skip-build", action="store_true")
+    parser.add_argument("--report", help="also write the measured numbers here")
+    parser.add_argument("--measured", help="compare this --report of an earlier run, nothing is built or run")
+    parser.add_argument("--baseline", default=BASELINE, help="baseline to compare with or to update")
+    args = parser.parse_args()
+
+    if args.measured:
+        with open(args.measured) as f:
+            report = json.load(f)
+    else:
+        if not args.skip_build:
+            build()
+        report = measure()
+    if args.report:
+        with open(args.report, "w") as f:
+            json.dump(report, f, indent=2)
+
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump({"threshold": DEFAULT_THRESHOLD, "metrics": report}, f, indent=2)
+            f.write("\n")
+        print("baseline written to " + args.baseline)
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print("no baseline in {}, record one with --update-baseline".format(args.baseline))
+        return 1
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    regressions = compare(report, baseline)
+    if regressions:
+        print("{} regressed over {:.0%}".format(", ".join(sorted(set(regressions))), baseline.get("threshold", DEFAULT_THRESHOLD)))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,80 @@
+"""
+Decodes binary log records of the firmware into text.
+
+    python tools/log_decode.py .pio/build/nanoatmega328/log_table.json /dev/ttyUSB0
+    python tools/log_decode.py log_table.json capture.bin
+
+Record: 0xA0 | level, message id, argc, argc * uint32 little endian.
+"""
+import json
+import re
+import struct
+import sys
+import time
+
+SYNC = 0xA0
+LEVELS = {1: "E", 2: "I", 3: "D"}
+ARGUMENT = re.compile(r"\{([udt])\}")
+
+
+def format_message(text, args):
+    values = iter(args)
+
+    def replace(match):
+        value = next(values, None)
+        if value is None:
+            return "?"
+        if match.group(1) == "d":
+            return str(struct.unpack("<i", struct.pack("<I", value))[0])
+        if match.group(1) == "t":
+            return time.strftime("%Y/%m/%d %H:%M:%S", time.gmtime(value))
+        return str(value)
+
+    return ARGUMENT.sub(replace, text)
+
+
+def decode(stream, messages, out):
+    while True:
+        head = stream.read(1)
+        if not head:
+            return
+        if head[0] & 0xF0 != SYNC or head[0] & 0x0F not in LEVELS:
+            # out of sync, skip until the next record start
+            continue
+        header = stream.read(2)
+        if len(header) < 2:
+            return
+        message_id, argc = header
+        payload = stream.read(4 * argc)
+        if len(payload) < 4 * argc:
+            return
+        args = struct.unpack("<%dI" % argc, payload)
+        if message_id < len(messages):
+            text = format_message(messages[message_id]["text"], args)
+        else:
+            text = "unknown message %d %s" % (message_id, list(args))
+        out.write("%s %s\n" % (LEVELS[head[0] & 0x0F], text))
+        out.flush()
+
+
+def open_source(path):
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial  # pyserial, installed with PlatformIO
+
+        return serial.Serial(path, 9800)
+    return open(path, "rb")
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    with open(sys.argv[1]) as f:
+        messages = json.load(f)
+    stream = open_source(sys.argv[2]) if len(sys.argv) > 2 else sys.stdin.buffer
+    decode(stream, messages, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,43 @@
+"""
+Builds the log decoder table from src/log_messages.h.
+
+As a PlatformIO pre-script it writes log_table.json into the build directory,
+standalone: python tools/log_table.py [src/log_messages.h] [log_table.json]
+"""
+import json
+import os
+import re
+import sys
+
+MESSAGE = re.compile(r'^\s*LOG_MESSAGE\((\w+),\s*"((?:[^"\\]|\\.)*)"\)')
+
+
+def read_messages(header):
+    messages = []
+    with open(header) as f:
+        for line in f:
+            match = MESSAGE.match(line)
+            if match:
+                messages.append({"name": match.group(1), "text": match.group(2)})
+    return messages
+
+
+def write_table(header, table):
+    messages = read_messages(header)
+    os.makedirs(os.path.dirname(os.path.abspath(table)), exist_ok=True)
+    with open(table, "w") as f:
+        json.dump(messages, f, indent=2)
+    return messages
+
+
+try:
+    Import("env")  # noqa: F821, provided by PlatformIO
+    write_table(
+        os.path.join(env.subst("$PROJECT_SRC_DIR"), "log_messages.h"),  # noqa: F821
+        os.path.join(env.subst("$BUILD_DIR"), "log_table.json"),  # noqa: F821
+    )
+except NameError:
+    if __name__ == "__main__":
+        header = sys.argv[1] if len(sys.argv) > 1 else "src/log_messages.h"
+        table = sys.argv[2] if len(sys.argv) > 2 else "log_table.json"
+        print("%d messages -> %s" % (len(write_table(header, table)), table))
@@ -0,0 +1,84 @@
+"""
+Lists the RAM and flash taken by every symbol of the firmware.
+
+As a PlatformIO post-script it writes size_report.txt next to firmware.elf
+after each link, standalone:
+python tools/size_report.py [firmware.elf] [size_report.txt] [--nm avr-nm]
+
+RAM is .data and .bss, flash is code, PROGMEM and the initial values of
+.data. On the AVR the data address space starts at 0x800000, .rodata
+there is copied to RAM like .data.
+"""
+import os
+import subprocess
+import sys
+
+RAM_SIZE = 2048
+# 32 KB less the 2 KB bootloader of the Nano
+FLASH_SIZE = 30720
+AVR_DATA_START = 0x800000
+
+
+def read_symbols(nm, elf):
+    output = subprocess.run([nm, "--size-sort", "--print-size", "--demangle", elf],
+                            check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        address, size, kind, name = int(parts[0], 16), int(parts[1], 16), parts[2].lower(), parts[3]
+        in_ram = kind in "bd" or (kind == "r" and address >= AVR_DATA_START)
+        in_flash = kind != "b"
+        symbols.append({
+            "name": name,
+            "section": kind,
+            "ram": size if in_ram else 0,
+            "flash": size if in_flash else 0,
+        })
+    return symbols
+
+
+def format_report(symbols):
+    ram = sum(s["ram"] for s in symbols)
+    flash = sum(s["flash"] for s in symbols)
+    lines = [
+        "RAM   %5d of %5d bytes, %.1f %%, the stack takes the rest" % (ram, RAM_SIZE, 100.0 * ram / RAM_SIZE),
+        "flash %5d of %5d bytes, %.1f %%" % (flash, FLASH_SIZE, 100.0 * flash / FLASH_SIZE),
+        "",
+        "%6s %6s  %s  %s" % ("ram", "flash", "s", "symbol"),
+    ]
+    for s in sorted(symbols, key=lambda s: (-s["ram"], -s["flash"], s["name"])):
+        lines.append("%6d %6d  %s  %s" % (s["ram"], s["flash"], s["section"], s["name"]))
+    return "\n".join(lines) + "\n"
+
+
+def write_report(nm, elf, report):
+    text = format_report(read_symbols(nm, elf))
+    with open(report, "w") as f:
+        f.write(text)
+    return text
+
+
+try:
+    Import("env")  # noqa: F821, provided by PlatformIO
+
+    def after_link(source, target, env):
+        elf = str(target[0])
+        report = os.path.join(os.path.dirname(elf), "size_report.txt")
+        nm = env.subst("$CC").replace("gcc", "nm")
+        text = write_report(nm, elf, report)
+        print("".join(text.splitlines(True)[:2]) + "per symbol -> " + report)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        args = sys.argv[1:]
+        nm = "avr-nm"
+        if "--nm" in args:
+            index = args.index("--nm")
+            nm = args[index + 1]
+            del args[index:index + 2]
+        elf = args[0] if len(args) > 0 else ".pio/build/nanoatmega328/firmware.elf"
+        report = args[1] if len(args) > 1 else "size_report.txt"
+        sys.stdout.write(write_report(nm, elf, report))
@@ -0,0 +1,224 @@
+"""
+Sets and reads the clock over the serial port.
+
+    python tools/time_sync.py PORT get             offset of the DS3231 to this host
+    python tools/time_sync.py PORT set             set the DS3231 to the time of this host
+    python tools/time_sync.py PORT epoch [UNIX]    read or set the epoch
+    python tools/time_sync.py PORT zone [INDEX]    read or select the time zone
+    python tools/time_sync.py PORT mode [INDEX]    read or select the display mode
+    options: --rounds N (8), --baud N (9800)
+
+The offset is measured NTP-style: a time_get frame is stamped by the clock
+when its last byte comes in and when the reply goes out. The round with
+the least delay is kept, the serialization of both frames at 10 bits a
+byte is taken off the ends. A set is aligned to a whole second of the host
+and written at the matching moment of the clock, so the DS3231 second
+starts with the host one.
+
+Frame: 0xB5, command, size, payload, CRC-8 (polynomial 0x07) of command to
+payload. Log records of the firmware on the same line are skipped.
+"""
+import struct
+import sys
+import time
+
+FRAME = 0xB5
+REPLY = 0x80
+LOG_LEVELS = (0xA1, 0xA2, 0xA3)
+TICKS_PER_SECOND = 32768
+
+TIME_GET, TIME_SET, EPOCH_GET, EPOCH_SET, ZONE_GET, ZONE_SET, MODE_GET, MODE_SET = range(1, 9)
+STATUS = ["accepted", "bad CRC", "unknown command", "bad size", "bad value", "DS3231 write failed", "a set is pending"]
+
+# time_get: request without payload, reply with status and two times
+TIME_GET_REQUEST_BYTES = 4
+TIME_GET_REPLY_BYTES = 17
+# a set is sent this long before the second it sets at least
+SET_LEAD = 1.0
+# the DS3231 steps a second after the set, the check waits for it
+VERIFY_DELAY = 2.5
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc << 1 ^ 0x07 if crc & 0x80 else crc << 1) & 0xFF
+    return crc
+
+
+class HostClock:
+    """Unix time with the resolution of the performance counter."""
+
+    def __init__(self):
+        self.unix = time.time()
+        self.counter = time.perf_counter()
+
+    def now(self):
+        return self.unix + time.perf_counter() - self.counter
+
+
+class Device:
+    def __init__(self, path, baud):
+        import serial  # pyserial, installed with PlatformIO
+
+        self.port = serial.Serial(path, baud, timeout=0.5)
+        self.byte_time = 10.0 / baud
+        self.clock = HostClock()
+        self.port.reset_input_buffer()
+
+    def send(self, command, payload=b""):
+        body = bytes([command, len(payload)]) + payload
+        sent = self.clock.now()
+        self.port.write(bytes([FRAME]) + body + bytes([crc8(body)]))
+        return sent
+
+    def read(self, size):
+        data = self.port.read(size)
+        if len(data) < size:
+            raise IOError("no reply from the clock")
+        return data
+
+    def receive(self, command, timeout=3.0):
+        """Returns status, payload and the host time of the last byte."""
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            head = self.port.read(1)
+            if not head:
+                continue
+            if head[0] in LOG_LEVELS:
+                _, argc = self.read(2)
+                self.read(4 * argc)
+                continue
+            if head[0] != FRAME:
+                continue
+            body = self.read(2)
+            body += self.read(body[1] + 1)
+            received = self.clock.now()
+            if crc8(body[:-1]) != body[-1] or body[1] < 1:
+                continue
+            if body[0] == command | REPLY or body[0] == REPLY:
+                return body[2], body[3:-1], received
+        raise IOError("no reply from the clock")
+
+    def request(self, command, payload=b""):
+        self.send(command, payload)
+        status, payload, _ = self.receive(command)
+        if status != 0:
+            raise IOError(STATUS[status] if status < len(STATUS) else "status %d" % status)
+        return payload
+
+    def measure(self, rounds):
+        """Returns offset of the clock to the host, delay and whether ticks count."""
+        best = None
+        locked = True
+        for _ in range(rounds):
+            sent = self.send(TIME_GET)
+            status, payload, received = self.receive(TIME_GET)
+            if status != 0 or len(payload) != 12:
+                continue
+            t2 = device_time(payload[0:6])
+            t3 = device_time(payload[6:12])
+            locked = locked and (payload[4:6] != b"\0\0" or payload[10:12] != b"\0\0")
+            t1 = sent + TIME_GET_REQUEST_BYTES * self.byte_time
+            t4 = received - TIME_GET_REPLY_BYTES * self.byte_time
+            delay = (t4 - t1) - (t3 - t2)
+            offset = ((t2 - t1) + (t3 - t4)) / 2
+            if best is None or delay < best[1]:
+                best = (offset, delay)
+            time.sleep(0.05)
+        if best is None:
+            raise IOError("no time_get reply")
+        return best[0], best[1], locked
+
+
+def device_time(data):
+    seconds, ticks = struct.unpack("<IH", data)
+    return seconds + ticks / float(TICKS_PER_SECOND)
+
+
+def pack_device_time(value):
+    seconds = int(value)
+    ticks = int(round((value - seconds) * TICKS_PER_SECOND))
+    if ticks == TICKS_PER_SECOND:
+        seconds, ticks = seconds + 1, 0
+    return struct.pack("<IH", seconds, ticks)
+
+
+def format_time(value):
+    return time.strftime("%Y/%m/%d %H:%M:%S", time.gmtime(value)) + (".%03d UTC" % (value % 1 * 1000))
+
+
+def print_offset(offset, delay, locked):
+    print("offset %+.4f s, delay %.4f s" % (offset, delay))
+    if not locked:
+        print("the clock has no ticks yet (32K count not locked or PROFILE build), 1 s resolution")
+
+
+def get_time(device, rounds):
+    offset, delay, locked = device.measure(rounds)
+    print("clock  %s" % format_time(device.clock.now() + offset))
+    print_offset(offset, delay, locked)
+
+
+def set_time(device, rounds):
+    offset, delay, locked = device.measure(rounds)
+    print_offset(offset, delay, locked)
+    target = int(device.clock.now() + SET_LEAD) + 1
+    device.send(TIME_SET, struct.pack("<I", target) + pack_device_time(target + offset))
+    status, payload, _ = device.receive(TIME_SET, timeout=SET_LEAD + 3)
+    if status != 0:
+        raise IOError(STATUS[status] if status < len(STATUS) else "status %d" % status)
+    print("set    %s, written at %+.4f s" % (format_time(target), device_time(payload) - offset - target))
+    time.sleep(VERIFY_DELAY)
+    print("check")
+    print_offset(*device.measure(rounds))
+
+
+def get_or_set(device, values, get_command, set_command, pack):
+    if values:
+        device.request(set_command, pack(int(values[0])))
+    return device.request(get_command)
+
+
+def main():
+    args = sys.argv[1:]
+    options = {"--rounds": 8, "--baud": 9800}
+    for name in options:
+        if name in args:
+            index = args.index(name)
+            options[name] = int(args[index + 1])
+            del args[index:index + 2]
+    if len(args) < 2:
+        print(__doc__)
+        return 1
+    device = Device(args[0], options["--baud"])
+    command, values = args[1], args[2:]
+    if command == "get":
+        get_time(device, options["--rounds"])
+    elif command == "set":
+        set_time(device, options["--rounds"])
+    elif command == "epoch":
+        payload = get_or_set(device, values, EPOCH_GET, EPOCH_SET, lambda v: struct.pack("<I", v))
+        print("epoch  %s" % format_time(struct.unpack("<I", payload)[0]))
+    elif command == "zone":
+        payload = get_or_set(device, values, ZONE_GET, ZONE_SET, lambda v: struct.pack("<B", v))
+        zone, minutes, count = struct.unpack("<BhB", payload)
+        print("zone   %d of %d, UTC%+d:%02d now" % (zone, count, int(minutes / 60), abs(minutes) % 60))
+    elif command == "mode":
+        payload = get_or_set(device, values, MODE_GET, MODE_SET, lambda v: struct.pack("<B", v))
+        mode, count = struct.unpack("<BB", payload)
+        print("mode   %d of %d" % (mode, count))
+    else:
+        print(__doc__)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except IOError as error:
+        print(error)
+        sys.exit(1)